@@ -34,9 +34,7 @@ void *stream_callback(struct bladerf *dev, struct bladerf_stream *stream,
         sdrstat.buff[ind+i]=(unsigned char)((sample[i]>>4)+127.5);
     unmlock(hbuffmtx);
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 
     /* stop stream callback */
     if (sdrstat.stopflag) {
@@ -379,7 +377,5 @@ extern void fbladerf_pushtomembuf(void)
         SDRPRINTF("end of file!\n");
     }
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 }
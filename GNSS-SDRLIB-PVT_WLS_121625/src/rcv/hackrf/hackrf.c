@@ -23,9 +23,7 @@ int stream_callback_hackrf(hackrf_transfer* transfer)
   unmlock(hbuffmtx);
 
 
-  mlock(hreadmtx);
-  sdrstat.buffcnt++;
-  unmlock(hreadmtx);
+  rcvpublish();
 
   return 0;
 }
@@ -267,7 +265,5 @@ extern void fhackrf_pushtomembuf(void)
         SDRPRINTF("end of file!\n");
     }
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 }
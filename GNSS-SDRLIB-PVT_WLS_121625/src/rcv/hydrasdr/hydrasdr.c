@@ -37,9 +37,7 @@ int rx_callback_hydrasdr(hydrasdr_transfer_t* transfer)
   //printf("IQ Block %ld stored to memory buffer.\n",sdrstat.buffcnt%MEMBUFFLEN);
 
   // Increment buffcnt
-  mlock(hreadmtx);
-  sdrstat.buffcnt++;
-  unmlock(hreadmtx);
+  rcvpublish();
 
   // Done
   return 0;
@@ -289,7 +287,5 @@ extern void fhydrasdr_pushtomembuf(void)
         SDRPRINTF("end of file!\n");
     }
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 }
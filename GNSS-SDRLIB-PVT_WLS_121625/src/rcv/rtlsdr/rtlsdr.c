@@ -19,9 +19,7 @@ void stream_callback_rtlsdr(unsigned char *buf, uint32_t len, void *ctx)
         buf,2*RTLSDR_DATABUFF_SIZE);
     unmlock(hbuffmtx);
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 
     if (sdrstat.stopflag) rtlsdr_cancel_async(dev);
 }
@@ -197,7 +195,5 @@ extern void frtlsdr_pushtomembuf(void)
         SDRPRINTF("end of file!\n");
     }
 
-    mlock(hreadmtx);
-    sdrstat.buffcnt++;
-    unmlock(hreadmtx);
+    rcvpublish();
 }
@@ -42,6 +42,7 @@
 #include "rtklib.h"
 #include <libusb-1.0/libusb.h>
 #include "ansiColorCodes.h"
+#include "sdrshm.h"
 #include <pthread.h>
 #include <ncurses.h>
 
@@ -120,6 +121,17 @@
 #define ACQSTEP       200              // doppler search frequency step (Hz)  
 #define ACQTH         3.0              // acquisition threshold (peak ratio)  
 #define ACQSLEEP      2000             // acquisition process interval (ms)  
+#define RESETSLEEP    10000            // reacquisition delay after reset (ms)  
+#define ACQRETRYS     20               // PRN retry backoff per failed acquisition (s)  
+#define ACQRETRYMAX   300              // max PRN retry backoff after failures (s)  
+#define SLOTLOSTS     30               // PRN retry backoff after loss of lock (s)  
+#define SLOTLOWELS    600              // PRN retry backoff after low elevation (s)  
+#define EPHPREDS      14400            // ephemeris age for visibility prediction (s)  
+
+#define SLOT_ACQFAIL  0                // slot release: acquisition failed  
+#define SLOT_LOST     1                // slot release: tracking/decode lost  
+#define SLOT_LOWEL    2                // slot release: low elevation  
+#define SLOT_SHED     3                // slot release: dropped by load shedding  
 
 // tracking setting  
 #define LOOP_L1CA     10               // loop interval  
@@ -129,6 +141,97 @@
 #define LOOP_B1IG     2                // loop interval  
 #define LOOP_SBAS     2                // loop interval  
 #define LOOP_LEX      4                // loop interval  
+#define CATCHUPMS     50               // backlog to start catch-up (ms)  
+#define CATCHUPBLK    100              // max code periods per call (catch-up)  
+#define BACKLOGTC     1.0              // backlog trend time constant (s)  
+#define LOCKKPRE      5                // lock detector block before bit sync (code periods)  
+#define LOCKM         20               // lock detector blocks per C/N0 estimate  
+#define LOCKPLIA      0.1              // PLL lock indicator smoothing factor  
+#define LOCKPLITH     0.5              // PLL lock indicator threshold (cos 2*phase error)  
+#define LOCKCN0TH     20.0             // C/N0 lock threshold (dB-Hz)  
+#define LOCKOPTMS     200              // time above both thresholds to declare lock (ms)  
+#define LOCKPESMS     800              // time below both thresholds to declare loss (ms)  
+#define LOCKWAITMS    3000             // max time from acquisition to lock (ms)  
+
+// pipeline stage latency probes (sdrprobe.c)  
+#define STAGE_ACQ     0                // acquisition (sdraqcuisition)  
+#define STAGE_COR     1                // correlator (one code period)  
+#define STAGE_NAV     2                // navigation (sdrnavigation)  
+#define STAGE_SYNC    3                // sync thread observables (one epoch)  
+#define STAGE_PVT     4                // PVT solution (pvtProcessor)  
+#define STAGES        5                // number of stages  
+#define PROBEBINS     128              // latency buckets (4 per octave of ns)  
+
+// traced pipeline events (sdrtrace.c)  
+#define TRACE_PUBLISH 0                // front end block published  
+#define TRACE_ACQ     1                // acquisition  
+#define TRACE_COR     2                // correlator (one code period)  
+#define TRACE_NAV     3                // navigation decode  
+#define TRACE_SYNC    4                // sync epoch (observables)  
+#define TRACE_PVT     5                // PVT solution  
+#define TRACE_RESET   6                // channel reset (resetStructs)  
+#define TRACES        7                // number of traced events  
+
+// event log ids (sdrevent.c, formatted by the consumer)  
+#define EV_CATCHUP    0                // channel catch-up mode  
+#define EV_CAUGHTUP   1                // channel caught up  
+#define EV_OVERRUN    2                // ring buffer overrun  
+#define EV_LOSTLOCK   3                // lock lost  
+#define EV_NOLOCK     4                // no lock after acquisition  
+#define EV_RESETNAV   5                // reset: no nav decode  
+#define EV_RESETEL    6                // reset: low elevation  
+#define EV_RESET      7                // channel reset  
+#define EV_RESETERR   8                // channel reset error  
+#define EV_OBSDELAY   9                // reset: no valid obs  
+#define EV_SLOTREL    10               // slot release (+SLOT_??? cause)  
+#define EV_PVTERR     14               // PVT error  
+#define EV_PVTFEW     15               // PVT: less than four SVs  
+#define EV_SATPOSNAN  16               // satPos NaN  
+#define EV_NOEKF      17               // EKF not installed  
+#define EV_POSNAN     18               // estRcvrPosn NaN  
+#define EV_DET        19               // estRcvrPosn rank too low  
+#define EV_TOPOCENT   20               // topocent error  
+#define EV_TROPO      21               // tropo error  
+#define EV_TOGEODIT   22               // togeod not converged  
+#define EV_TOGEOD     23               // togeod error  
+#define EV_PRESNR     24               // precheck: low SNR  
+#define EV_PREWEEK    25               // precheck: week  
+#define EV_PRETOW     26               // precheck: TOW  
+#define EV_PRELOWPR   27               // precheck: low pseudorange  
+#define EV_PREHIGHPR  28               // precheck: high pseudorange  
+#define EV_PREEPH     29               // precheck: ephemeris  
+#define EV_PREEL      30               // precheck: elevation mask  
+#define EV_OBSLIST    31               // updateObsList error  
+#define EVENTS        32               // number of event ids  
+
+// supervisor (load shedding)  
+#define SUPINTMS      500              // supervisor interval (ms)  
+#define SHEDLOADHI    0.85             // cpu load to shed one more level  
+#define SHEDLOADLO    0.60             // cpu load to restore one level  
+#define SHEDHOLDHI    2                // overloaded intervals before shedding  
+#define SHEDHOLDLO    20               // headroom intervals before restoring  
+#define SHEDSNR       35.0             // SNR of strong channel (long loop)  
+#define SHEDMINCH     5                // min tracking channels (no drop)  
+#define SHED_NONE     0                // shed level: none  
+#define SHED_ACQ      1                // shed level: acquisition paused  
+#define SHED_TAPS     2                // shed level: E/P/L taps only  
+#define SHED_LOOP     3                // shed level: long loop (strong ch)  
+#define SHED_DROP     4                // shed level: drop weak channels  
+#define SHEDLEVELS    5                // number of shed levels  
+
+// worker pool  
+#define MAXWORKER     64               // max number of pool workers  
+#define POOLIDLEMS    100              // max idle wait of a pool worker (ms)  
+#define DATAWAITMS    100              // max wait for new front end data (ms)  
+#define STEPWAITDATA  -1               // channel step result: wait for data  
+#define MAXNODE       64               // max NUMA node number + 1  
+
+// thread roles (placement by [THREADS] <ROLE>CPUS/SCHED/PRIO/NODE)  
+#define ROLE_INGEST   0                // front end data (callback/data thread)  
+#define ROLE_CHANNEL  1                // acquisition/tracking (workers, channels)  
+#define ROLE_SYNC     2                // sync/PVT thread  
+#define ROLE_GUI      3                // GUI, keyboard and supervisor threads  
+#define ROLES         4                // number of thread roles  
 
 // navigation parameter  
 #define NAVSYNCTH       50             // navigation frame synch. threshold  
@@ -151,6 +254,8 @@
 #define PTIMING       68.802           // pseudo range generation timing (ms)  
 #define OBSINTERPN    80               // # of obs. stock for interpolation  
 #define SNSMOOTHMS    100              // SNR smoothing interval (ms)  
+#define OBSWINMS      100              // interpolation window before epoch (ms)  
+#define WEEKMS        604800000        // milliseconds of week  
 
 // code generation parameter  
 #define MAXGPSSATNO   210              // max satellite number  
@@ -176,7 +281,6 @@
 #define HIGH_PR       92e-3 * CTIME
 
 // SNR thresholds
-#define SNR_RESET_THRES		15  	// Threshold to reset sdrch channel
 #define SNR_PVT_THRES 		19      // Threshold to use obs for PVT
 
 // The sdrthread function uses this as a check to make sure GPS week
@@ -204,21 +308,55 @@
 // thread functions  
 #define mlock_t       pthread_mutex_t
 #define initmlock(f)  pthread_mutex_init(&f,NULL)
+#ifdef LOCKPROF // mutex contention profiler (sdrlock.c)  
+#define mlock(f)      ({static int lpsite_=-1; \
+                        lockprofacq(&(f),#f,__FILE__,__LINE__,&lpsite_);})
+#define unmlock(f)    lockprofrel(&(f))
+#else
 #define mlock(f)      pthread_mutex_lock(&f)
 #define unmlock(f)    pthread_mutex_unlock(&f)
+#endif
 #define delmlock(f)   pthread_mutex_destroy(&f)
 #define event_t       pthread_cond_t
 #define initevent(f)  pthread_cond_init(&f,NULL)
 #define setevent(f)   pthread_cond_signal(&f)
+#define setevents(f)  pthread_cond_broadcast(&f)
+#ifdef LOCKPROF
+#define waitevent(f,m) lockprofwait(&(f),&(m),NULL)
+#define timedwaitevent(f,m,t) lockprofwait(&(f),&(m),t)
+#else
 #define waitevent(f,m) pthread_cond_wait(&f,&m)
+#define timedwaitevent(f,m,t) pthread_cond_timedwait(&f,&m,t)
+#endif
 #define delevent(f)   pthread_cond_destroy(&f)
 #define waitthread(f) pthread_join(f,NULL)
 #define cratethread(f,func,arg) pthread_create(&f,NULL,func,arg)
 #define THRETVAL      NULL
 
+#define CACHELINE     64 // cache line size (bytes)
+
+// single writer sequence lock (odd: update in progress, readers retry)  
+#define seqwritebegin(s) do {__atomic_store_n(&(s),(s)+1,__ATOMIC_RELAXED); \
+                             __atomic_thread_fence(__ATOMIC_SEQ_CST);} while (0)
+#define seqwriteend(s)   __atomic_store_n(&(s),(s)+1,__ATOMIC_RELEASE)
+#define seqreadretry(s,v) (__atomic_thread_fence(__ATOMIC_ACQUIRE), \
+                           __atomic_load_n(&(s),__ATOMIC_RELAXED)!=(v))
+
 // type definition ----------------------------------------------------------- 
 typedef fftwf_complex cpx_t; // complex type for fft  
 
+// int8 correlator kernel (sdrcmn.c): data,n,carrier phase/step word,code,I,Q  
+typedef void (*corrfunc_t)(const char *, int, uint32_t, uint32_t,
+                           const char *, double *, double *);
+
+// thread role placement struct  
+typedef struct {
+        char cpus[256];  // cpu list, e.g. 0-3,6 ("": process cpus)  
+        int policy;      // scheduling policy (SCHED_OTHER/FIFO/RR)  
+        int prio;        // scheduling priority (1-99 for FIFO/RR)  
+        int node;        // NUMA node of the thread memory (-1: any)  
+} sdrrole_t;
+
 // sdr initialization struct  
 typedef struct {
         int fend;        // front end type  
@@ -256,13 +394,50 @@ typedef struct {
         int trkcorrn;    // number of correlation points  
         int trkcorrd;    // interval of correlation points (sample)  
         int trkcorrp;    // correlation points (sample)  
+        int trkquant;    // tracking quantization (0:int8,1:1bit,2:2bit)  
         double trkdllb[2]; // dll noise bandwidth (Hz)  
         double trkpllb[2]; // pll noise bandwidth (Hz)  
         double trkfllb[2]; // fll noise bandwidth (Hz)  
         int rtlsdrppmerr; // clock collection for RTL-SDR  
         int ekfFilterOn;  // flag to run EKF (rather than BLS)
+        int pool;        // channel worker pool (0:thread per channel)
+        int nworker;     // number of pool workers (0:one per allowed cpu)
+        int nprn;        // number of PRN assets (PRN list, nch: slots)
+        char assetcache[256]; // PRN code asset cache file ("": none)
+        char statsfile[256]; // stage latency summary file ("": none)
+        char tracefile[256]; // trace event file ("": no tracer)
+        int traceon;     // tracing on at start (0: 't' key)
+        int metricsport; // metrics endpoint port (0: none)
+        char metricsaddr[256]; // metrics endpoint address ("": loopback)
+        char shmname[256]; // status segment shm object name ("": none)
+        int headless;    // headless mode (no ncurses, no keyboard thread)
+        char statuslog[256]; // headless status log ("": stderr)
+        int statusms;    // headless status line interval (ms, 0: none)
+        char cpus[256];  // process cpu list ("": all but the last four)
+        sdrrole_t role[ROLES]; // thread role placement
 } sdrini_t;
 
+// navigation status snapshot (published by the sync thread)  
+typedef struct {
+        unsigned int seq; // sequence lock  
+        int nsatValid;   // number of valid observations  
+        int obsValidList[MAXSAT]; // valid observation PRNs  
+        double lat,lon,hgt,gdop; // position and GDOP  
+        double xyzdt[4]; // ECEF position and clock bias  
+        double obs_v[11*MAXSAT]; // observation data (see obs_v)  
+        double vk1_v[MAXSAT]; // estimator residuals  
+        double rk1_v[MAXSAT]; // EKF measurement variances  
+} sdrnavsnap_t;
+
+// per slot counters and subscriptions (kept over channel resets, relaxed
+// atomics)  
+typedef struct {
+        uint64_t overrun; // ring buffer overruns  
+        uint64_t dropsamp; // samples overwritten before tracking  
+        uint64_t nreset; // channel resets (resetStructs)  
+        int tapsubs;     // full tap set subscribers of the slot (0: E/P/L)  
+} sdrchcnt_t;
+
 // sdr current state struct  
 typedef struct {
         int stopflag;    // stop flag  
@@ -290,6 +465,16 @@ typedef struct {
         double xyzdt[4];
         double elapsedTime;
         int azElCalculatedflag;
+        int tapsubs;     // full tap set subscribers for all channels
+        int shed;        // load shedding level (SHED_???)
+        int shedch[MAXSAT]; // channel dropped by load shedding
+        int shedcnt[SHEDLEVELS]; // load shedding actions per level
+        double shedsec[SHEDLEVELS]; // time spent at each level (s)
+        double load;     // channel thread cpu load (fraction of cpus)
+        double loadmax;  // peak channel thread cpu load
+        int obsnext;     // next observation output epoch (ms of week, 0:any)
+        sdrnavsnap_t navsnap; // navigation status snapshot  
+        sdrchcnt_t chcnt[MAXSAT]; // per slot counters  
 } sdrstat_t;
 
 // sdr observation struct  
@@ -304,6 +489,18 @@ typedef struct {
         double S;        // SNR (dB-Hz)  
 } sdrobs_t;
 
+// sdr observation interpolation window (from the output epoch backwards)  
+typedef struct {
+        int n;           // number of entries  
+        double tow;      // time of week of the epoch (s)  
+        double S;        // signal to noise ratio (dB-Hz)  
+        uint64_t codei[OBSINTERPN]; // code index  
+        uint64_t cntout[OBSINTERPN]; // loop counter  
+        double remcout[OBSINTERPN]; // remained code phase (chip)  
+        double L[OBSINTERPN]; // carrier phase (cycle)  
+        double D[OBSINTERPN]; // doppler frequency (Hz)  
+} sdrobswin_t;
+
 // sdr acquisition struct  
 typedef struct {
         int intg;        // number of integration  
@@ -345,15 +542,7 @@ typedef struct {
         double carrErr;  // carrier tracking error  
         double freqErr;  // frequencyr error in FLL  
         uint64_t buffloc; // current buffer location  
-        double tow[OBSINTERPN]; // time of week (s)  
-        uint64_t codei[OBSINTERPN]; // code phase (sample)  
-        uint64_t codeisum[OBSINTERPN]; // code phase for SNR computation (sample)  
-        uint64_t cntout[OBSINTERPN]; // loop counter  
-        double remcout[OBSINTERPN]; // remained code phase (chip) 
-        double L[OBSINTERPN];// carrier phase (cycle)  
-        double D[OBSINTERPN];// doppler frequency (Hz)  
-        double S[OBSINTERPN];// signal to noise ratio (dB-Hz)  
-        double *II;      // correlation (in-phase)  
+        double *II;      // correlation (in-phase, channel arena block)  
         double *QQ;      // correlation (quadrature-phase)  
         double *oldI;    // previous correlation (I-phase)  
         double *oldQ;    // previous correlation (Q-phase)  
@@ -364,6 +553,8 @@ typedef struct {
         double Isum;     // correlation for SNR computation (I-phase)  
         int loop;        // loop filter interval  
         int loopms;      // loop filter interval (ms)  
+        int loopdef;     // default loop filter interval  
+        int flagloopshed; // long loop interval requested (load shedding)  
         int flagpolarityadd; // polarity (half cycle ambiguity) add flag  
         int flagremcarradd; // remained carrier phase add flag  
         int flagloopfilter; // loop filter update flag  
@@ -371,8 +562,40 @@ typedef struct {
         int *corrp;      // correlation points (sample)  
         double *corrx;   // correlation points (for plotting)  
         int ne,nl;       // early/late correlation point  
+        int quant;       // quantization (0:int8,1:1bit,2:2bit)  
+        corrfunc_t corrfunc; // specialized correlator (NULL: generic)  
+        corrfunc_t corrfuncepl; // specialized E/P/L correlator (NULL: generic)  
+        double backlog;  // samples behind the front end (ms)  
+        double backlogtrend; // backlog trend (ms/s, smoothed)  
+        unsigned long backlogtick; // time of backlog update (us)  
+        int flagcatchup; // catch-up mode flag  
+        uint64_t dropend; // end of the overwritten samples counted  
+        double lockI,lockQ; // lock detector block sums (prompt)  
+        double lockW;    // lock detector wide band power (block)  
+        int lockk;       // code periods in the lock detector block  
+        int lockm;       // blocks in the C/N0 estimate  
+        double locknp;   // sum of narrow/wide band power ratios  
+        double lockkm;   // sum of block lengths (code periods)  
+        double cn0;      // C/N0 (dB-Hz, narrow/wide band power estimator)  
+        double pli;      // PLL lock indicator (cos 2*phase error, smoothed)  
+        double lockgood; // time both lock tests passed (ms, optimistic)  
+        double lockbad;  // time both lock tests failed (ms, pessimistic)  
+        double lockms;   // time since tracking started (ms)  
+        int flaglock;    // signal lock flag  
+        int flaglost;    // reacquisition request (1:lost,2:no lock,3:overrun)  
         sdrtrkprm_t prm1; // tracking parameter struct  
         sdrtrkprm_t prm2; // tracking parameter struct  
+        // observation history (read by the sync thread, own cache lines)  
+        unsigned int obsseq __attribute__((aligned(CACHELINE))); // sequence lock  
+        int obsepoch;    // last observation epoch reached (ms of week)  
+        double tow[OBSINTERPN]; // time of week (s)  
+        uint64_t codei[OBSINTERPN]; // code phase (sample)  
+        uint64_t codeisum[OBSINTERPN]; // code phase for SNR computation (sample)  
+        uint64_t cntout[OBSINTERPN]; // loop counter  
+        double remcout[OBSINTERPN]; // remained code phase (chip) 
+        double L[OBSINTERPN];// carrier phase (cycle)  
+        double D[OBSINTERPN];// doppler frequency (Hz)  
+        double S[OBSINTERPN];// signal to noise ratio (dB-Hz)  
 } sdrtrk_t;
 
 // sdr ephemeris struct  
@@ -413,8 +636,11 @@ typedef struct {
         int biti;        // current navigation bit index  
         int cnt;         // navigation bit counter for synchronization  
         double bitIP;    // current navigation bit (IP data)  
-        int *fbits;      // frame bits  
-        int *fbitsdec;   // decoded frame bits  
+        uint64_t *fbits; // frame bits (packed bit ring, 1: bit -1)  
+        uint64_t nfbits; // frame bits received (ring head)  
+        unsigned int fbitsmask; // ring word index mask (words-1)  
+        uint64_t prepat; // preamble bits (packed, 1: bit -1)  
+        int *fbitsdec;   // decoded frame bits (SBAS FEC output)  
         int update;      // decode interval (ms)  
         int *bitsync;    // frame bits synchronization count  
         int synci;       // frame bits synchronization index  
@@ -437,7 +663,7 @@ typedef struct {
         sdrsbas_t sbas;  // SBAS message struct  
 } sdrnav_t;
 
-// sdr channel struct  
+// sdr channel struct (cache line aligned, hot tracking state first)  
 typedef struct {
         thread_t hsdr;   // thread handle  
         int no;          // channel number  
@@ -455,8 +681,8 @@ typedef struct {
         int f_bias;  // front end bias-tee  
         int f_clock; // front end clock ref  
         double foffset;  // frequency offset (Hz)  
-        short *code;     // original code  
-        cpx_t *xcode;    // resampled code in frequency domain  
+        short *code;     // original code (shared asset, read only)  
+        cpx_t *xcode;    // resampled code in frequency domain (shared)  
         int clen;        // code length  
         double crate;    // code chip rate (Hz)  
         double ctime;    // code period (s)  
@@ -465,14 +691,51 @@ typedef struct {
         int nsamp;       // number of samples in one code (doppler=0Hz)  
         int currnsamp;   // current number of samples in one code  
         int nsampchip;   // number of samples in one code chip (doppler=0Hz)  
-        sdracq_t acq;    // acquisition struct  
         sdrtrk_t trk;    // tracking struct  
-        sdrnav_t nav;    // navigation struct  
         int flagacq;     // acquisition flag  
         int flagtrk;     // tracking flag  
         double elapsed_time_snr;
         double elapsed_time_nav;
-} sdrch_t;
+        uint64_t cpuus;  // channel cpu time (us)
+        uint64_t trksamp; // samples processed by tracking
+        uint64_t buffloc; // buffer location of the channel
+        uint64_t bufflocnow; // buffer location of the front end
+        uint64_t cnt;    // code period counter
+        uint64_t loopcnt; // loop filter counter
+        double *acqpower; // acquisition power (work buffer)
+        time_t start_acq_timer; // time of acquisition
+        double elapsed_acq_time; // time since acquisition (s)
+        uint64_t needcnt; // buffer count needed by tracking (data wait)
+        sdrnav_t nav;    // navigation struct (ephemeris/SBAS at the tail)  
+        sdracq_t acq;    // acquisition struct (not used while tracking)  
+        int asset;       // PRN asset of the slot (PRN list index)  
+} __attribute__((aligned(CACHELINE))) sdrch_t;
+
+// PRN asset struct (PRN list entry, assigned to a channel slot)  
+typedef struct {
+        int slot;        // assigned slot (-1: free)  
+        int nacq;        // successful acquisitions  
+        int nfail;       // failed acquisitions in a row  
+        int nlost;       // losses of lock or elevation  
+        time_t ttry;     // last assignment to a slot  
+        time_t tretry;   // not assigned again before (backoff)  
+        int flageph;     // ephemeris available  
+        sdreph_t eph;    // last decoded ephemeris (visibility prediction)  
+} sdrprn_t;
+
+// PRN code asset (shared by the channels, read only after assetbuild())  
+typedef struct {
+        int prn;         // PRN  
+        int ctype;       // code type  
+        double f_sf;     // sampling rate (Hz)  
+        short *code;     // original code  
+        int clen;        // code length  
+        double crate;    // code chip rate (Hz)  
+        int nsamp;       // number of samples in one code (doppler=0Hz)  
+        int nfft;        // number of FFT points (2*nsamp)  
+        short *rcode;    // resampled code (zero padded to nfft)  
+        cpx_t *xcode;    // resampled code in frequency domain  
+} sdrasset_t;
 
 // EKF struct (varR used by WLS estimator)
 typedef struct {
@@ -484,8 +747,26 @@ typedef struct {
 typedef struct {
   int message_count;
   char *messages[100];
+  uint64_t message_total; // messages posted (headless status log)
 } sdrgui_t;
 
+// channel worker struct (worker pool)
+typedef struct {
+        thread_t hworker; // worker thread handle
+        int no;          // worker number
+        mlock_t mtx;     // deque access mutex
+        int deque[MAXSAT]; // runnable channels (ring buffer)
+        int head;        // deque head (owner pops here)
+        int n;           // number of channels in deque
+        int timed[MAXSAT]; // waiting channels (owner only)
+        unsigned long wake[MAXSAT]; // wake time of waiting channels (us)
+        uint64_t need[MAXSAT]; // buffer count of waiting channels (0:none)
+        int ntimed;      // number of waiting channels
+        uint64_t nstep;  // channel steps run
+        uint64_t nsteal; // channels stolen from other workers
+        uint64_t nidle;  // idle waits
+} sdrworker_t;
+
 // global variables -----------------------------------------------------------
 extern thread_t hmainthread;  // main thread handle  
 extern thread_t hsyncthread;  // synchronization thread handle  
@@ -493,14 +774,19 @@ extern thread_t hkeythread;   // keyboard thread handle
 extern thread_t hdatathread;   // keyboard thread handle  
 extern thread_t hserverthread;   // server thread  
 extern thread_t hmsgthread;   // GUI messages thread  
+extern thread_t hsupthread;   // supervisor thread  
 
 extern mlock_t hbuffmtx;      // buffer access mutex  
 extern mlock_t hreadmtx;      // buffloc access mutex  
 extern mlock_t hfftmtx;       // fft function mutex  
-extern mlock_t hobsmtx;       // observation data access mutex  
+extern mlock_t hobsmtx;       // observation epoch event mutex  
 extern mlock_t hresetmtx;     // sdr channel reset flag mutex  
 extern mlock_t hobsvecmtx;    // observation vector access mutex  
 extern mlock_t hmsgmtx;       // messages access mutex  
+extern mlock_t hslotmtx;      // channel slot assignment mutex  
+
+extern event_t hbuffevt;      // front end data published event (hreadmtx)  
+extern event_t hepochevt;     // observation epoch reached event (hobsmtx)  
 
 extern sdrini_t sdrini;       // sdr initialization struct  
 extern sdrstat_t sdrstat;     // sdr state struct  
@@ -512,25 +798,103 @@ extern sdrgui_t sdrgui;       // GUI
 extern void startsdr(void);
 extern void quitsdr(sdrini_t *ini, int stop);
 extern void *sdrthread(void *arg);
+extern int sdrchstep(sdrch_t *sdr);
+extern void sdrchfinish(sdrch_t *sdr);
 extern void *datathread(void *arg);
-extern int resetStructs(void *arg);
+extern int resetStructs(void *arg, int k);
 extern int checkObsDelay(int prn);
 
 // sdrsync.c ------------------------------------------------------------------
 extern void *syncthread(void * arg);
+extern void syncepoch(sdrch_t *sdr, int epoch);
+extern void getnavsnap(sdrnavsnap_t *snap);
+extern double getnavobs(int prn, int k);
+
+// sdrpool.c ------------------------------------------------------------------
+extern int poolstart(void);
+extern void poolwait(void);
+
+// sdrsched.c -----------------------------------------------------------------
+extern int parsecpus(const char *str, cpu_set_t *set);
+extern void schedprocess(void);
+extern int rolecpus(int role);
+extern void schedrole(int role);
+extern void schedbuff(void *buff, size_t size);
+
+// sdrslot.c ------------------------------------------------------------------
+extern int slotinitch(int slot, int k);
+extern int slotstart(void);
+extern int slotrelease(sdrch_t *sdr, int cause);
+extern void slotacquired(sdrch_t *sdr);
+extern sdrch_t *prnch(int prn);
+
+// sdrprobe.c -----------------------------------------------------------------
+extern uint64_t probens(void);
+extern void probeadd(int stage, int ch, uint64_t t0);
+extern uint64_t probestat(int stage, int ch, double *stat);
+extern void probethread(const char *name);
+extern void probesample(void);
+extern void probeline(char *buff, int size);
+extern void probesummary(void);
+
+// sdrtrace.c -----------------------------------------------------------------
+extern void traceend(int ev, int ch, uint64_t t0);
+extern void tracestart(void);
+extern int tracetoggle(void);
+extern void tracestop(void);
+
+// sdrmetrics.c ---------------------------------------------------------------
+extern void metricsstart(void);
+extern void metricsstop(void);
+
+// sdrevent.c -----------------------------------------------------------------
+extern void evlog(int id, double a0, double a1, double a2, double a3);
+extern void evdrain(void);
+
+// sdrdaemon.c ----------------------------------------------------------------
+extern void daemonsignals(void);
+extern void daemonrun(void);
+
+// sdrshm.c -------------------------------------------------------------------
+extern void shmstart(void);
+extern void shmpublish(void);
+extern void shmstop(void);
+
+// sdrlock.c ------------------------------------------------------------------
+extern int lockprofacq(pthread_mutex_t *mtx, const char *name,
+                       const char *file, int line, int *site);
+extern int lockprofrel(pthread_mutex_t *mtx);
+extern int lockprofwait(pthread_cond_t *cond, pthread_mutex_t *mtx,
+                        const struct timespec *t);
+extern void lockprofreport(void);
+extern void lockprofdump(void);
+
+// sdrasset.c -----------------------------------------------------------------
+extern int assetbuild(void);
+extern const sdrasset_t *assetget(int prn, int ctype, double f_sf);
+extern void assetfree(void);
+
+// sdrsup.c -------------------------------------------------------------------
+extern void *supthread(void *arg);
+extern void supsummary(void);
 
 // sdracq.c -------------------------------------------------------------------
 extern uint64_t sdraqcuisition(sdrch_t *sdr, double *power);
 extern int checkacquisition(double *P, sdrch_t *sdr);
 
 // sdrtrk.c -------------------------------------------------------------------
-extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt);
+extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t *buffloc, uint64_t *cnt,
+                            uint64_t *loopcnt);
 extern void cumsumcorr(sdrtrk_t *trk, int polarity);
 extern void clearcumsumcorr(sdrtrk_t *trk);
+extern void lockdetect(sdrch_t *sdr);
 extern void pll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt);
 extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt);
 extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt,
                        sdrtrk_t *trk, int flag);
+extern double getsnr(sdrch_t *sdr);
+extern void subscribetaps(sdrch_t *sdr);
+extern void unsubscribetaps(sdrch_t *sdr);
 
 // sdrinit.c ------------------------------------------------------------------
 extern int readinifile(sdrini_t *ini);
@@ -539,23 +903,28 @@ extern void openhandles(void);
 extern void closehandles(void);
 extern void initacqstruct(int sys, int ctype, int prn, sdracq_t *acq);
 extern void inittrkprmstruct(sdrtrk_t *trk);
-extern int inittrkstruct(int sat, int ctype, double ctime, sdrtrk_t *trk);
+extern int inittrkstruct(int chno, int sat, int ctype, double ctime,
+                         sdrtrk_t *trk);
 extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav);
 extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
                      int ftype, int f_gain, int f_bias, int f_clock,
                      double f_cf, double f_sf, double f_if,
                      sdrch_t *sdr);
 extern void freesdrch(sdrch_t *sdr);
+extern void freetrkarena(void);
 
 // sdrcmn.c -------------------------------------------------------------------
 extern int getfullpath(char *relpath, char *abspath);
 extern unsigned long tickgetus(void);
+extern unsigned long threadcpuus(void);
+extern unsigned int seqreadbegin(const unsigned int *seq);
 extern void sleepus(int usec);
 extern void settimeout(struct timespec *timeout, int waitms);
 extern double log2(double n);
 extern int calcfftnum(double x, int next);
 extern void *sdrmalloc(size_t size);
 extern void sdrfree(void *p);
+extern void *sdrscratch(int i, size_t size);
 extern cpx_t *cpxmalloc(int n);
 extern void cpxfree(cpx_t *cpx);
 extern void cpxfft(fftwf_plan plan, cpx_t *cpx, int n);
@@ -596,7 +965,15 @@ extern void pcorrelator(const char *data, int dtype, double ti, int n,
 extern void correlator(const char *data, int dtype, double ti, int n,
                        double freq, double phi0, double crate, double coff,
                        int* s, int ns, double *II, double *QQ, double *remc,
-                       double *remp, short* codein, int coden);
+                       double *remp, short* codein, int coden,
+                       corrfunc_t func);
+extern corrfunc_t getcorrfunc(int dtype, int corrn, int corrd);
+extern double packbits(const char *data, int dtype, int n, int quant,
+                       uint64_t *sI, uint64_t *sQ, uint64_t *mI, uint64_t *mQ);
+extern void bcorrelator(const char *data, int dtype, double ti, int n,
+                        double freq, double phi0, double crate, double coff,
+                        int* s, int ns, double *II, double *QQ, double *remc,
+                        double *remp, short* codein, int coden, int quant);
 extern int leap_seconds(long gps_seconds);
 extern time_t gps_to_utc(int gps_week, double gps_tow);
 
@@ -636,6 +1013,7 @@ extern void bits2byte(int *bits, int nbits, int nbin, int right, uint8_t *bin);
 extern void interleave(const int *in, int row, int col, int *out);
 extern int checksync(double IP, double IPold, sdrnav_t *nav);
 extern int checkbit(double IP, int loopms, sdrnav_t *nav);
+extern uint64_t getfbits(const sdrnav_t *nav, int pos, int n);
 extern void predecodefec(sdrnav_t *nav);
 extern int paritycheck(sdrnav_t *nav);
 extern int findpreamble(sdrnav_t *nav);
@@ -648,7 +1026,7 @@ extern int decode_e1b(sdrnav_t *nav);
 extern int decode_g1(sdrnav_t *nav);
 extern int decode_b1i(sdrnav_t *nav);
 extern int decode_l1sbas(sdrnav_t *nav);
-extern int paritycheck_l1ca(int *bits);
+extern int paritycheck_l1ca(uint32_t word);
 
 // sdrrcv.c -------------------------------------------------------------------
 extern int rcvinit(sdrini_t *ini);
@@ -657,6 +1035,8 @@ extern int rcvgrabstart(sdrini_t *ini);
 extern int rcvgrabdata(sdrini_t *ini);
 extern int rcvgetbuff(sdrini_t *ini, uint64_t buffloc, int n, int ftype,
                       int dtype, char *expbuf);
+extern void rcvpublish(void);
+extern uint64_t rcvwaitbuff(uint64_t cnt, int waitms);
 extern void file_pushtomembuf(void);
 extern void file_getbuff(uint64_t buffloc, int n, int ftype, int dtype,
                          char *expbuf);
@@ -667,6 +1047,7 @@ extern void file_getbuff(uint64_t buffloc, int n, int ftype, int dtype,
 
 // sdrgui.c -------------------------------------------------------------------
 extern void add_message(const char *msg);
+extern void add_messagef(const char *fmt, ...);
 extern void updateNavStatusWin(WINDOW *win1, int counter);
 extern void updateProgramStatusWin(WINDOW *win2, int height);
 
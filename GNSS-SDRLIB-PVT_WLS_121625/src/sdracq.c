@@ -7,7 +7,8 @@
 #include "sdr.h"
 
 /* sdr acquisition function ----------------------------------------------------
-* sdr acquisition function called from sdr channel thread
+* sdr acquisition function called from sdr channel step. does not wait on
+* failure, the caller retries after ACQSLEEP
 * args   : sdrch_t *sdr     I/O sdr channel struct
 *          double *power    O   normalized correlation power vector (2D array)
 * return : uint64_t             current buffer location
@@ -69,9 +70,6 @@ extern uint64_t sdraqcuisition(sdrch_t *sdr, double *power)
         sdr->trk.carrfreq=sdr->acq.acqfreq;
         sdr->trk.codefreq=sdr->crate;
     }
-    else {
-        sleepms(ACQSLEEP);
-    }
     sdrfree(data);
     return buffloc;
 }
@@ -0,0 +1,326 @@
+//-----------------------------------------------------------------------------
+// sdrasset.c : shared PRN code assets (code, resampled code, FFT of the code)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+#include <errno.h>
+
+// cache file: header, then per asset the key/size record followed by code
+// (clen shorts), rcode (nfft shorts) and xcode (nfft cpx_t)
+#define ASSETMAGIC   "SDRASSET"
+#define ASSETVER     1                // cache file version (code generators)
+
+typedef struct {
+        char magic[8];   // ASSETMAGIC
+        int ver;         // ASSETVER
+        int cpxsize;     // sizeof(cpx_t)
+        int n;           // number of assets
+} assethead_t;
+
+typedef struct {
+        int prn,ctype;   // PRN, code type
+        double f_sf;     // sampling rate (Hz)
+        int clen;        // code length
+        double crate;    // code chip rate (Hz)
+        int nsamp,nfft;  // samples in one code, FFT points
+} assetrec_t;
+
+static sdrasset_t asset[MAXSAT]; // asset store (one per distinct PRN asset)
+static int nasset=0;             // number of assets
+static int nextasset;            // next asset to build (pre-pass workers)
+static fftwf_plan assetplan[MAXSAT]; // FFT plan of each asset (shared)
+
+// find asset ------------------------------------------------------------------
+static int findasset(int prn, int ctype, double f_sf)
+{
+    int i;
+
+    for (i=0;i<nasset;i++) {
+        if (asset[i].prn==prn&&asset[i].ctype==ctype&&asset[i].f_sf==f_sf) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// free asset ------------------------------------------------------------------
+static void freeasset(sdrasset_t *a)
+{
+    free(a->code);
+    sdrfree(a->rcode);
+    cpxfree(a->xcode);
+    a->code=NULL; a->rcode=NULL; a->xcode=NULL;
+}
+
+// build asset -----------------------------------------------------------------
+// generate, resample and transform the code of an asset (same steps as the
+// former per channel code generation in initsdrch())
+// args   : sdrasset_t *a    I/O asset (key set)
+//          fftwf_plan plan  I   FFT plan for nfft points (in place)
+// return : int                  0:okay -1:error
+//-----------------------------------------------------------------------------
+static int buildasset(sdrasset_t *a, fftwf_plan plan)
+{
+    double ci;
+    int i;
+
+    if (!(a->rcode=(short *)sdrmalloc(sizeof(short)*a->nfft))||
+        !(a->xcode=cpxmalloc(a->nfft))) {
+        return -1;
+    }
+    ci=(1/a->f_sf)*a->crate;
+    for (i=0;i<a->nfft;i++) a->rcode[i]=0; // zero padding
+    rescode(a->code,a->clen,0,0,ci,a->nsamp,a->rcode); // resampling
+    cpxcpx(a->rcode,NULL,1.0,a->nfft,a->xcode);
+    fftwf_execute_dft(plan,a->xcode,a->xcode); // FFT for acquisition
+    return 0;
+}
+
+// pre-pass worker thread ------------------------------------------------------
+static void *assetthread(void *arg)
+{
+    int i;
+
+    while ((i=__atomic_fetch_add(&nextasset,1,__ATOMIC_RELAXED))<nasset) {
+        if (asset[i].xcode) continue; // cached or built in advance
+        if (buildasset(&asset[i],assetplan[i])<0) {
+            SDRPRINTF("error: asset G%02d ctype %d memory allocation\n",
+                asset[i].prn,asset[i].ctype);
+        }
+    }
+    return THRETVAL;
+}
+
+// read asset from cache file --------------------------------------------------
+// the cached code must equal the generated one (generator changes)
+static int readasset(FILE *fp, const assetrec_t *rec, sdrasset_t *a)
+{
+    short *code;
+    int ret=-1;
+
+    if (!(code=(short *)malloc(sizeof(short)*rec->clen))) return -1;
+
+    if (fread(code,sizeof(short),rec->clen,fp)==(size_t)rec->clen&&
+        !memcmp(code,a->code,sizeof(short)*rec->clen)&&
+        (a->rcode=(short *)sdrmalloc(sizeof(short)*rec->nfft))&&
+        (a->xcode=cpxmalloc(rec->nfft))&&
+        fread(a->rcode,sizeof(short),rec->nfft,fp)==(size_t)rec->nfft&&
+        fread(a->xcode,sizeof(cpx_t),rec->nfft,fp)==(size_t)rec->nfft) {
+        ret=0;
+    }
+    else {
+        sdrfree(a->rcode); cpxfree(a->xcode);
+        a->rcode=NULL; a->xcode=NULL;
+    }
+    free(code);
+    return ret;
+}
+
+// load cache file -------------------------------------------------------------
+// load the assets of the store found in the cache file (key and sizes must
+// match what the code generators give now)
+// args   : char   *file     I   cache file
+// return : int                  number of assets loaded
+//-----------------------------------------------------------------------------
+static int loadcache(const char *file)
+{
+    FILE *fp;
+    assethead_t head;
+    assetrec_t rec;
+    long skip;
+    int i,j,n=0;
+
+    if (!(fp=fopen(file,"rb"))) return 0;
+
+    if (fread(&head,sizeof(head),1,fp)!=1||
+        memcmp(head.magic,ASSETMAGIC,8)||head.ver!=ASSETVER||
+        head.cpxsize!=(int)sizeof(cpx_t)) {
+        SDRPRINTF("PRN code asset cache %s: wrong version, rebuilt\n",file);
+        fclose(fp);
+        return 0;
+    }
+    for (i=0;i<head.n&&fread(&rec,sizeof(rec),1,fp)==1;i++) {
+        skip=rec.clen*sizeof(short)+rec.nfft*(sizeof(short)+sizeof(cpx_t));
+        j=findasset(rec.prn,rec.ctype,rec.f_sf);
+
+        if (j<0||asset[j].xcode||rec.clen!=asset[j].clen||
+            rec.crate!=asset[j].crate||rec.nsamp!=asset[j].nsamp||
+            rec.nfft!=asset[j].nfft) {
+            if (fseek(fp,skip,SEEK_CUR)) break;
+            continue;
+        }
+        if (readasset(fp,&rec,&asset[j])<0) break;
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+// save cache file -------------------------------------------------------------
+static void savecache(const char *file)
+{
+    FILE *fp;
+    assethead_t head={{0}};
+    assetrec_t rec;
+    int i;
+
+    if (!(fp=fopen(file,"wb"))) {
+        SDRPRINTF("error: PRN code asset cache %s: %s\n",file,strerror(errno));
+        return;
+    }
+    memcpy(head.magic,ASSETMAGIC,8);
+    head.ver=ASSETVER;
+    head.cpxsize=(int)sizeof(cpx_t);
+    head.n=nasset;
+    fwrite(&head,sizeof(head),1,fp);
+
+    for (i=0;i<nasset;i++) {
+        memset(&rec,0,sizeof(rec));
+        rec.prn=asset[i].prn;
+        rec.ctype=asset[i].ctype;
+        rec.f_sf=asset[i].f_sf;
+        rec.clen=asset[i].clen;
+        rec.crate=asset[i].crate;
+        rec.nsamp=asset[i].nsamp;
+        rec.nfft=asset[i].nfft;
+        fwrite(&rec,sizeof(rec),1,fp);
+        fwrite(asset[i].code,sizeof(short),asset[i].clen,fp);
+        fwrite(asset[i].rcode,sizeof(short),asset[i].nfft,fp);
+        fwrite(asset[i].xcode,sizeof(cpx_t),asset[i].nfft,fp);
+    }
+    if (fclose(fp)) {
+        SDRPRINTF("error: PRN code asset cache %s: %s\n",file,strerror(errno));
+    }
+}
+
+// build asset store -----------------------------------------------------------
+// build the PRN code assets of all PRN list entries once at startup: codes
+// are generated here, the resampled codes and their FFTs are loaded from the
+// cache file ([CHANNEL] ASSETCACHE) or computed in parallel and then saved.
+// channels only refer to the assets, so channel start and reset are cheap.
+// args   : none
+// return : int                  0:okay -1:error
+// note : fftw planning is not thread safe, the plans are created here and
+//        the workers use the new-array execute. gencode() is called here too
+//        (the L1C Legendre sequence is a static table in sdrcode.c).
+//-----------------------------------------------------------------------------
+extern int assetbuild(void)
+{
+    sdrasset_t *a;
+    thread_t th[MAXWORKER];
+    cpx_t *tmp;
+    fftwf_plan plan;
+    cpu_set_t cpuset;
+    unsigned long t0=tickgetus();
+    int i,j,k,f,nth=1,ncache=0,nbuild=0;
+
+    assetfree();
+
+    for (k=0;k<sdrini.nprn;k++) {
+        f=sdrini.ftype[k]-1;
+        if (findasset(sdrini.prn[k],sdrini.ctype[k],sdrini.f_sf[f])>=0) {
+            continue;
+        }
+        a=&asset[nasset];
+        memset(a,0,sizeof(sdrasset_t));
+        a->prn=sdrini.prn[k];
+        a->ctype=sdrini.ctype[k];
+        a->f_sf=sdrini.f_sf[f];
+        if (!(a->code=gencode(a->prn,a->ctype,&a->clen,&a->crate))) {
+            SDRPRINTF("error: gencode\n"); return -1;
+        }
+        a->nsamp=(int)(a->f_sf*(a->clen/a->crate));
+        a->nfft=2*a->nsamp;
+        nasset++;
+    }
+    if (sdrini.assetcache[0]) ncache=loadcache(sdrini.assetcache);
+
+    for (i=0;i<nasset;i++) nbuild+=!asset[i].xcode;
+
+    // FFT plans (one per FFT size)
+    for (i=0;i<nasset;i++) {
+        assetplan[i]=NULL;
+        if (asset[i].xcode) continue;
+        for (j=0;j<i;j++) {
+            if (assetplan[j]&&asset[j].nfft==asset[i].nfft) {
+                assetplan[i]=assetplan[j]; break;
+            }
+        }
+        if (assetplan[i]) continue;
+        if (!(tmp=cpxmalloc(asset[i].nfft))) {
+            SDRPRINTF("error: assetbuild memory allocation\n"); return -1;
+        }
+        fftwf_plan_with_nthreads(1);
+        assetplan[i]=fftwf_plan_dft_1d(asset[i].nfft,tmp,tmp,FFTW_FORWARD,
+                                       FFTW_ESTIMATE);
+        cpxfree(tmp);
+    }
+    // parallel pre-pass over the assets not in the cache
+    if (nbuild>0) {
+        CPU_ZERO(&cpuset);
+        if (!sched_getaffinity(0,sizeof(cpuset),&cpuset)) {
+            nth=CPU_COUNT(&cpuset);
+        }
+        if (nth>MAXWORKER) nth=MAXWORKER;
+        if (nth>nbuild) nth=nbuild;
+        if (nth<1) nth=1;
+
+        nextasset=0;
+        for (i=0;i<nth;i++) {
+            if (pthread_create(&th[i],NULL,assetthread,NULL)) break;
+        }
+        if (i==0) assetthread(NULL);
+        for (j=0;j<i;j++) waitthread(th[j]);
+        nth=i>0?i:1;
+    }
+    for (i=0;i<nasset;i++) {
+        if (!(plan=assetplan[i])) continue;
+        for (j=i;j<nasset;j++) if (assetplan[j]==plan) assetplan[j]=NULL;
+        fftwf_destroy_plan(plan);
+    }
+    for (i=0;i<nasset;i++) {
+        if (!asset[i].xcode) {
+            SDRPRINTF("error: assetbuild G%02d ctype %d\n",asset[i].prn,
+                asset[i].ctype);
+            return -1;
+        }
+    }
+    if (sdrini.assetcache[0]&&nbuild>0) savecache(sdrini.assetcache);
+
+    SDRPRINTF("PRN code assets: %d (%d cached, %d built by %d threads) "
+        "%.1f ms\n",nasset,ncache,nbuild,nbuild>0?nth:0,
+        (tickgetus()-t0)/1000.0);
+    return 0;
+}
+
+// get asset -------------------------------------------------------------------
+// look up the shared code asset of a PRN list entry (read only)
+// args   : int    prn       I   PRN
+//          int    ctype     I   code type (CTYPE_???)
+//          double f_sf      I   sampling rate (Hz)
+// return : sdrasset_t*          asset (NULL: not in the store)
+//-----------------------------------------------------------------------------
+extern const sdrasset_t *assetget(int prn, int ctype, double f_sf)
+{
+    int i=findasset(prn,ctype,f_sf);
+
+    if (i<0) {
+        SDRPRINTF("error: no PRN code asset G%02d ctype %d\n",prn,ctype);
+        return NULL;
+    }
+    return &asset[i];
+}
+
+// free asset store ------------------------------------------------------------
+// free the assets (after freesdrch() of all channels)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void assetfree(void)
+{
+    int i;
+
+    for (i=0;i<nasset;i++) freeasset(&asset[i]);
+    nasset=0;
+}
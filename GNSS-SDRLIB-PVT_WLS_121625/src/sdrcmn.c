@@ -7,10 +7,25 @@
 //-----------------------------------------------------------------------------*/
 #include "sdr.h"
 
-#define CDIV          32               /* carrier lookup table (cycle) */
-#define CMASK         0x1F             /* carrier lookup table mask */
 #define CSCALE        (1.0/32.0)       /* carrier lookup table scale (LSB) */
 
+/* carrier NCO lookup table depth (bits), override with -DNCOBITS=n. a deeper
+   table lowers the sin/cos quantization loss (about 0.23 dB at 4 bits, 0.06 dB
+   at 5 bits) at the cost of a second table lookup in the SIMD path */
+#ifndef NCOBITS
+#if defined(SSE2_ENABLE)
+#define NCOBITS       4
+#else
+#define NCOBITS       5
+#endif
+#endif
+#if defined(SSE2_ENABLE)&&(NCOBITS<2||NCOBITS>5)
+#error "NCOBITS must be 2-5 with SSE2_ENABLE"
+#endif
+#define NCODIV        (1<<NCOBITS)     /* carrier lookup table (cycle) */
+#define NCOSHIFT      (32-NCOBITS)     /* phase word to table index shift */
+#define NCOSCALE      4294967296.0     /* phase word scale (2^32/cycle) */
+
 /* get full path from relative path --------------------------------------------
 * args   : char *relpath    I   relative path
 *          char *fullpath   O   full path
@@ -50,6 +65,65 @@ extern unsigned long tickgetus(void)
 #endif
 }
 
+/* sleep micro second ---------------------------------------------------------
+* sleep current thread
+* args   : int   usec       I   time to sleep (us) (no sleep if <=0)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void sleepus(int usec)
+{
+        struct timespec ts;
+
+        if (usec<=0) return;
+        ts.tv_sec=(time_t)(usec/1000000);
+        ts.tv_nsec=(long)(usec%1000000*1000);
+        nanosleep(&ts,NULL);
+}
+
+/* set timeout ---------------------------------------------------------------
+* set absolute timeout for timed event waits (CLOCK_REALTIME)
+* args   : struct timespec *timeout O timeout time
+*          int   waitms     I   wait time from now (ms)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void settimeout(struct timespec *timeout, int waitms)
+{
+        clock_gettime(CLOCK_REALTIME,timeout);
+        timeout->tv_sec+=waitms/1000;
+        timeout->tv_nsec+=(long)(waitms%1000)*1000000L;
+        if (timeout->tv_nsec>=1000000000L) {
+                timeout->tv_sec++;
+                timeout->tv_nsec-=1000000000L;
+        }
+}
+
+/* get thread cpu time (micro second) ------------------------------------------
+* get cpu time consumed by the calling thread (sleeps and waits not counted)
+* args   : none
+* return : thread cpu time in us (0: not available)
+*-----------------------------------------------------------------------------*/
+extern unsigned long threadcpuus(void)
+{
+        struct timespec tp={0};
+
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID,&tp)) return 0;
+        return tp.tv_sec*1000000UL+tp.tv_nsec/1000UL;
+}
+
+/* begin sequence lock read ---------------------------------------------------
+* wait until no update is in progress and return the sequence to check with
+* seqreadretry() after the copy (see seqwritebegin()/seqwriteend())
+* args   : unsigned int *seq I  sequence lock
+* return : sequence lock value (even)
+*-----------------------------------------------------------------------------*/
+extern unsigned int seqreadbegin(const unsigned int *seq)
+{
+        unsigned int v;
+
+        while ((v=__atomic_load_n(seq,__ATOMIC_ACQUIRE))&1) sched_yield();
+        return v;
+}
+
 /* calculation log2(x) ---------------------------------------------------------
 * args   : double x         I   x data
 * return : double               log2(x)
@@ -89,6 +163,27 @@ extern void *sdrmalloc(size_t size)
 #endif
 }
 
+/* per-thread scratch buffer ---------------------------------------------------
+* grow-only work buffer of the calling thread for per code period arrays of the
+* tracking correlators (avoids an allocation per correlator call)
+* args   : int    i         I   buffer index (0-2: correlators, 3: tracking
+*                               sample block, see sdrtracking())
+*          size_t size      I   required size (bytes)
+* return : void*                buffer (NULL: allocation error)
+*-----------------------------------------------------------------------------*/
+extern void *sdrscratch(int i, size_t size)
+{
+        static __thread void *buff[4];
+        static __thread size_t len[4];
+
+        if (len[i]<size) {
+                sdrfree(buff[i]);
+                buff[i]=sdrmalloc(size);
+                len[i]=buff[i]?size:0;
+        }
+        return buff[i];
+}
+
 /* sdr free --------------------------------------------------------------------
 * free data
 * args   : void   *p        I/O input/output complex data
@@ -278,6 +373,25 @@ extern void cpxpspec(fftwf_plan plan, cpx_t *cpx, int n, int flagsum,
         }
 }
 
+/* carrier NCO phase word -------------------------------------------------------
+* convert carrier phase/frequency to/from 32-bit NCO phase words
+* (1 LSB = 2^-32 cycle). phase words wrap modulo 2^32 so the carrier phase is
+* carried between epochs without accumulated rounding.
+*-----------------------------------------------------------------------------*/
+static uint32_t phasetoword(double phi)
+{
+        double cyc=phi/DPI;
+        return (uint32_t)(uint64_t)((cyc-floor(cyc))*NCOSCALE);
+}
+static uint32_t freqtoword(double freq, double ti)
+{
+        return (uint32_t)(int64_t)floor(freq*ti*NCOSCALE+0.5);
+}
+static double wordtophase(uint32_t ph)
+{
+        return ph*(DPI/NCOSCALE);
+}
+
 /* fundamental functions using SIMD --------------------------------------------
 * note : SSE2 instructions are used
 *-----------------------------------------------------------------------------*/
@@ -332,30 +446,65 @@ extern void cpxpspec(fftwf_plan plan, cpx_t *cpx, int n, int flagsum,
                 LOAD_INT8(_x1,_x2,src,zero); \
                 MUL_INT16(dst,_x1,_x2,xmm1,xmm2); \
 }
-/* double to int32: xmm{int32}=(xmm1,xmm2){double} ---------------------------*/
-#define DBLTOINT32(xmm,xmm1,xmm2) { \
-                __m128i _int1,_int2; \
-                _int1=_mm_cvttpd_epi32(xmm1); \
-                _int2=_mm_cvttpd_epi32(xmm2); \
-                _int2=_mm_slli_si128(_int2,8); \
-                xmm=_mm_add_epi32(_int1,_int2); \
-}
-/* double to int16: xmm{int16}=(xmm1,...,xmm4){double}&mask{int32} -----------*/
-#define DBLTOINT16(xmm,xmm1,xmm2,xmm3,xmm4,mask) { \
-                __m128i _int3,_int4; \
-                DBLTOINT32(_int3,xmm1,xmm2); \
-                DBLTOINT32(_int4,xmm3,xmm4); \
-                _int3=_mm_and_si128(_int3,mask); \
-                _int4=_mm_and_si128(_int4,mask); \
-                xmm=_mm_packs_epi32(_int3,_int4); \
-}
-/* multiply int8 with lut:dst[16]{int16}=(xmm1,xmm2){int8}.*xmm3{int8}[index] */
-#define MIX_INT8(dst,xmm1,xmm2,xmm3,index,zero) { \
-                __m128i _x,_x1,_x2; \
-                _x=_mm_shuffle_epi8(xmm3,index); \
-                EXPAND_INT8(_x1,_x2,_x,zero); \
+/* phase word to index: xmm{int8}=(xmm1,...,xmm4){uint32}>>NCOSHIFT ----------*/
+#define PHASETOINDEX(xmm,xmm1,xmm2,xmm3,xmm4) { \
+                __m128i _i1,_i2; \
+                _i1=_mm_packs_epi32(_mm_srli_epi32(xmm1,NCOSHIFT), \
+                                    _mm_srli_epi32(xmm2,NCOSHIFT)); \
+                _i2=_mm_packs_epi32(_mm_srli_epi32(xmm3,NCOSHIFT), \
+                                    _mm_srli_epi32(xmm4,NCOSHIFT)); \
+                xmm=_mm_packus_epi16(_i1,_i2); \
+}
+/* advance nco: (xmm1,...,xmm4){uint32}+=step{uint32} ------------------------*/
+#define NCOSTEP(xmm1,xmm2,xmm3,xmm4,step) { \
+                xmm1=_mm_add_epi32(xmm1,step); \
+                xmm2=_mm_add_epi32(xmm2,step); \
+                xmm3=_mm_add_epi32(xmm3,step); \
+                xmm4=_mm_add_epi32(xmm4,step); \
+}
+/* lookup int8: xmm{int8}=lut[index] (lut: 2x16 entries) ---------------------*/
+#if NCOBITS<=4
+#define LUT_INT8(xmm,lut,index) { \
+                xmm=_mm_shuffle_epi8(lut[0],index); \
+}
+#else
+#define LUT_INT8(xmm,lut,index) { \
+                __m128i _lo,_hi,_m,_k=_mm_set1_epi8(15); \
+                _lo=_mm_shuffle_epi8(lut[0],_mm_and_si128(index,_k)); \
+                _hi=_mm_shuffle_epi8(lut[1],_mm_and_si128(index,_k)); \
+                _m =_mm_cmpgt_epi8(index,_k); \
+                xmm=_mm_or_si128(_mm_and_si128(_m,_hi),_mm_andnot_si128(_m,_lo)); \
+}
+#endif
+/* multiply int8: dst[16]{int16}=(xmm1,xmm2){int16}.*xmm3{int8} --------------*/
+#define MIX_INT8(dst,xmm1,xmm2,xmm3,zero) { \
+                __m128i _x1,_x2; \
+                EXPAND_INT8(_x1,_x2,xmm3,zero); \
                 MUL_INT16(dst,_x1,_x2,xmm1,xmm2); \
 }
+/* multiply and add int8: xmm{int32}+=|xmm1|{int8}.*xmm2{int8} --------------
+* xmm2 has to be pre-signed by the signs of xmm1 (see dot_int8) */
+#define MULADD_INT8(xmm,xmm1,xmm2,ones) { \
+                xmm=_mm_add_epi32(xmm,_mm_madd_epi16( \
+                    _mm_maddubs_epi16(xmm1,xmm2),ones)); \
+}
+
+/* int8 local carrier lookup table (cos,sin,-sin) x NCODIV -------------------*/
+static char carrlut[3][32];
+static int carrlutinit=0;
+
+static void initcarrlut(void)
+{
+        int i;
+
+        if (__atomic_load_n(&carrlutinit,__ATOMIC_ACQUIRE)) return;
+        for (i=0; i<NCODIV; i++) {
+                carrlut[0][i]=(char)floor((cos(DPI/NCODIV*i)/CSCALE+0.5));
+                carrlut[1][i]=(char)floor((sin(DPI/NCODIV*i)/CSCALE+0.5));
+                carrlut[2][i]=(char)-carrlut[1][i];
+        }
+        __atomic_store_n(&carrlutinit,1,__ATOMIC_RELEASE);
+}
 #endif /* SSE2_ENABLE */
 
 #if defined(AVX2_ENABLE)
@@ -941,126 +1090,299 @@ extern double rescode(const short *code, int len, double coff, int smax,
 *          double freq      I   carrier frequency (Hz)
 *          double phi0      I   initial phase (rad)
 *          short  *I,*Q     O   carrier mixed data I, Q component
-* return : double               phase remainder
+* return : double               phase remainder (0<=prem<2*pi)
+* notes  : local carrier is a 32-bit fixed-point nco (phase word + increment
+*          per sample) indexed into a NCODIV entry sin/cos table. the phase
+*          remainder is the nco phase word of sample n.
 *-----------------------------------------------------------------------------*/
 extern double mixcarr(const char *data, int dtype, double ti, int n,
                       double freq, double phi0, short *II, short *QQ)
 {
         const char *p;
-        double phi,ps,prem;
+        uint32_t ph=phasetoword(phi0),step=freqtoword(freq,ti);
+        int i;
 
 #if !defined(SSE2_ENABLE)
-        static short cost[CDIV]={0},sint[CDIV]={0};
-        int i,index;
+        static short cost[NCODIV]={0},sint[NCODIV]={0};
+        uint32_t phi=ph;
+        int index;
 
         /* initialize local carrier table */
         if (!cost[0]) {
-                for (i=0; i<CDIV; i++) {
-                        cost[i]=(short)floor((cos(DPI/CDIV*i)/CSCALE+0.5));
-                        sint[i]=(short)floor((sin(DPI/CDIV*i)/CSCALE+0.5));
+                for (i=0; i<NCODIV; i++) {
+                        cost[i]=(short)floor((cos(DPI/NCODIV*i)/CSCALE+0.5));
+                        sint[i]=(short)floor((sin(DPI/NCODIV*i)/CSCALE+0.5));
                 }
         }
-        phi=phi0*CDIV/DPI;
-        ps=freq*CDIV*ti; /* phase step */
-
         if (dtype==DTYPEIQ) { /* complex */
-                for (p=data; p<data+n*2; p+=2,II++,QQ++,phi+=ps) {
-                        index=((int)phi)&CMASK;
+                for (p=data; p<data+n*2; p+=2,II++,QQ++,phi+=step) {
+                        index=phi>>NCOSHIFT;
                         *II=cost[index]*p[0]-sint[index]*p[1];
                         *QQ=sint[index]*p[0]+cost[index]*p[1];
                 }
         }
         if (dtype==DTYPEI) { /* real */
-                for (p=data; p<data+n; p++,II++,QQ++,phi+=ps) {
-                        index=((int)phi)&CMASK;
+                for (p=data; p<data+n; p++,II++,QQ++,phi+=step) {
+                        index=phi>>NCOSHIFT;
                         *II=cost[index]*p[0];
                         *QQ=sint[index]*p[0];
                 }
         }
-        prem=phi*DPI/CDIV;
-        while(prem>DPI) prem-=DPI;
-        return prem;
 #else
-        static char cost[16]={0},sint[16]={0};
         short I1[16]={0},I2[16]={0},Q1[16]={0},Q2[16]={0};
-        int i;
-        __m128d xmm1,xmm2,xmm3,xmm4,xmm5,xmm6,xmm7,xmm8,xmm9;
-        __m128i dat1,dat2,dat3,dat4,ind1,ind2,xcos,xsin;
+        uint32_t phv[16];
+        __m128i ph1,ph2,ph3,ph4,step16,xlut[2],ylut[2];
+        __m128i dat1,dat2,dat3,dat4,ind,xcos,xsin;
         __m128i zero=_mm_setzero_si128();
-        __m128i mask4=_mm_set1_epi32(15);
         __m128i mask8=_mm_set1_epi16(255);
 
-        if (!cost[0]) {
-                for (i=0; i<16; i++) {
-                        cost[i]=(char)floor((cos(DPI/16*i)/CSCALE+0.5));
-                        sint[i]=(char)floor((sin(DPI/16*i)/CSCALE+0.5));
-                }
-        }
-        phi=phi0/DPI*16-floor(phi0/DPI)*16;
-        ps=freq*16*ti;
-        xmm1=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm2=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm3=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm4=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm5=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm6=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm7=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm8=_mm_set_pd(phi+ps,phi); phi+=ps*2;
-        xmm9=_mm_set1_pd(ps*16);
-        xcos=_mm_loadu_si128((__m128i *)cost);
-        xsin=_mm_loadu_si128((__m128i *)sint);
+        initcarrlut();
+        for (i=0; i<16; i++) phv[i]=ph+(uint32_t)i*step;
+        ph1=_mm_loadu_si128((__m128i *)&phv[ 0]);
+        ph2=_mm_loadu_si128((__m128i *)&phv[ 4]);
+        ph3=_mm_loadu_si128((__m128i *)&phv[ 8]);
+        ph4=_mm_loadu_si128((__m128i *)&phv[12]);
+        step16=_mm_set1_epi32((int)(step*16u));
+        xlut[0]=_mm_loadu_si128((__m128i *)&carrlut[0][ 0]);
+        xlut[1]=_mm_loadu_si128((__m128i *)&carrlut[0][16]);
+        ylut[0]=_mm_loadu_si128((__m128i *)&carrlut[1][ 0]);
+        ylut[1]=_mm_loadu_si128((__m128i *)&carrlut[1][16]);
 
         if (dtype==DTYPEIQ) { /* complex */
                 for (p=data; p<data+n*2; p+=32,II+=16,QQ+=16) {
                         LOAD_INT8C(dat1,dat2,p,zero,mask8);
                         LOAD_INT8C(dat3,dat4,p+16,zero,mask8);
 
-                        DBLTOINT16(ind1,xmm1,xmm2,xmm3,xmm4,mask4);
-                        DBLTOINT16(ind2,xmm5,xmm6,xmm7,xmm8,mask4);
-                        ind1=_mm_packus_epi16(ind1,ind2);
-                        MIX_INT8(I1,dat1,dat3,xcos,ind1,zero);
-                        MIX_INT8(I2,dat1,dat3,xsin,ind1,zero);
-                        MIX_INT8(Q1,dat2,dat4,xsin,ind1,zero);
-                        MIX_INT8(Q2,dat2,dat4,xcos,ind1,zero);
+                        PHASETOINDEX(ind,ph1,ph2,ph3,ph4);
+                        LUT_INT8(xcos,xlut,ind);
+                        LUT_INT8(xsin,ylut,ind);
+                        MIX_INT8(I1,dat1,dat3,xcos,zero);
+                        MIX_INT8(I2,dat1,dat3,xsin,zero);
+                        MIX_INT8(Q1,dat2,dat4,xsin,zero);
+                        MIX_INT8(Q2,dat2,dat4,xcos,zero);
                         for (i=0; i<16; i++) {
                                 II[i]=I1[i]-Q1[i];
                                 QQ[i]=I2[i]+Q2[i];
                         }
-                        xmm1=_mm_add_pd(xmm1,xmm9);
-                        xmm2=_mm_add_pd(xmm2,xmm9);
-                        xmm3=_mm_add_pd(xmm3,xmm9);
-                        xmm4=_mm_add_pd(xmm4,xmm9);
-                        xmm5=_mm_add_pd(xmm5,xmm9);
-                        xmm6=_mm_add_pd(xmm6,xmm9);
-                        xmm7=_mm_add_pd(xmm7,xmm9);
-                        xmm8=_mm_add_pd(xmm8,xmm9);
+                        NCOSTEP(ph1,ph2,ph3,ph4,step16);
                 }
         }
         if (dtype==DTYPEI) { /* real */
                 for (p=data; p<data+n; p+=16,II+=16,QQ+=16) {
                         LOAD_INT8(dat1,dat2,p,zero);
 
-                        DBLTOINT16(ind1,xmm1,xmm2,xmm3,xmm4,mask4);
-                        DBLTOINT16(ind2,xmm5,xmm6,xmm7,xmm8,mask4);
-                        ind1=_mm_packus_epi16(ind1,ind2);
-                        MIX_INT8(II,dat1,dat2,xcos,ind1,zero);
-                        MIX_INT8(QQ,dat1,dat2,xsin,ind1,zero);
-                        xmm1=_mm_add_pd(xmm1,xmm9);
-                        xmm2=_mm_add_pd(xmm2,xmm9);
-                        xmm3=_mm_add_pd(xmm3,xmm9);
-                        xmm4=_mm_add_pd(xmm4,xmm9);
-                        xmm5=_mm_add_pd(xmm5,xmm9);
-                        xmm6=_mm_add_pd(xmm6,xmm9);
-                        xmm7=_mm_add_pd(xmm7,xmm9);
-                        xmm8=_mm_add_pd(xmm8,xmm9);
+                        PHASETOINDEX(ind,ph1,ph2,ph3,ph4);
+                        LUT_INT8(xcos,xlut,ind);
+                        LUT_INT8(xsin,ylut,ind);
+                        MIX_INT8(II,dat1,dat2,xcos,zero);
+                        MIX_INT8(QQ,dat1,dat2,xsin,zero);
+                        NCOSTEP(ph1,ph2,ph3,ph4,step16);
                 }
         }
-        prem=phi0+freq*ti*n*DPI;
-        while(prem>DPI) prem-=DPI;
-        return prem;
 #endif
+        return wordtophase(ph+(uint32_t)n*step);
 }
 
+#if defined(SSE2_ENABLE)
+#define MAXCORRTAP    33               /* max taps of int8 correlator */
+
+/* int8 correlator -------------------------------------------------------------
+* mix local carrier and multiply code in int8 and integrate in int32
+* args   : char   *data     I   sampling data (n x dtype, +32 bytes readable)
+*          int    dtype     I   sampling data type (1:real,2:complex)
+*          int    n         I   number of samples
+*          uint32_t ph      I   carrier nco phase word
+*          uint32_t step    I   carrier nco phase word increment per sample
+*          char   *code     I   resampled code (dtype bytes per sample)
+*          int    *off      I   code offset of taps (sample)
+*                               (NULL: P,E1,L1,... spaced by corrd)
+*          int    ntap      I   number of taps (<=MAXCORRTAP)
+*          int    corrd     I   tap spacing (sample) (off==NULL)
+*          double *II,*QQ   O   correlation I,Q
+* return : none
+* notes  : complex data is used interleaved (I,Q) with interleaved carrier
+*          vectors (cos,-sin) and (sin,cos), so one maddubs yields the mixed
+*          product of a sample. the carrier and data signs are folded into the
+*          carrier once per block; each tap is a sign and a maddubs.
+*          always inlined: with constant dtype/ntap/corrd (see DEF_CORR_INT8)
+*          the branches fold and the tap loops unroll into registers.
+*-----------------------------------------------------------------------------*/
+static inline __attribute__((always_inline))
+void dot_int8(const char *data, int dtype, int n, uint32_t ph, uint32_t step,
+              const char *code, const int *off, int ntap, int corrd,
+              double *II, double *QQ)
+{
+        static const char vmask[64]={
+                -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1};
+        const char *p,*c;
+        uint32_t phv[16];
+        int i,j,k,nv,acc[4],to[MAXCORRTAP];
+        __m128i ph1,ph2,ph3,ph4,step16,xlut[2],ylut[2],nlut[2];
+        __m128i ind,xcos,xsin,xnsin,d[2],a[2],b[2],ad[2],mk;
+        __m128i sumI[MAXCORRTAP],sumQ[MAXCORRTAP];
+        __m128i ones=_mm_set1_epi16(1);
+
+        initcarrlut();
+        for (i=0; i<16; i++) phv[i]=ph+(uint32_t)i*step;
+        ph1=_mm_loadu_si128((__m128i *)&phv[ 0]);
+        ph2=_mm_loadu_si128((__m128i *)&phv[ 4]);
+        ph3=_mm_loadu_si128((__m128i *)&phv[ 8]);
+        ph4=_mm_loadu_si128((__m128i *)&phv[12]);
+        step16=_mm_set1_epi32((int)(step*16u));
+        for (i=0; i<2; i++) {
+                xlut[i]=_mm_loadu_si128((__m128i *)&carrlut[0][16*i]);
+                ylut[i]=_mm_loadu_si128((__m128i *)&carrlut[1][16*i]);
+                nlut[i]=_mm_loadu_si128((__m128i *)&carrlut[2][16*i]);
+        }
+        for (k=0; k<ntap; k++) {
+                sumI[k]=sumQ[k]=_mm_setzero_si128();
+                if (off) to[k]=off[k];
+                else to[k]=ntap/2*corrd+(k==0?0:(k%2?-1:1)*((k+1)/2)*corrd);
+        }
+        for (i=0,p=data; i<n; i+=16,p+=16*dtype) {
+                PHASETOINDEX(ind,ph1,ph2,ph3,ph4);
+                LUT_INT8(xcos,xlut,ind);
+                LUT_INT8(xsin,ylut,ind);
+                NCOSTEP(ph1,ph2,ph3,ph4,step16);
+
+                nv=(n-i<16?n-i:16)*dtype; /* valid bytes in block */
+
+                if (dtype==DTYPEIQ) { /* complex */
+                        LUT_INT8(xnsin,nlut,ind);
+                        a[0]=_mm_unpacklo_epi8(xcos,xnsin);
+                        a[1]=_mm_unpackhi_epi8(xcos,xnsin);
+                        b[0]=_mm_unpacklo_epi8(xsin,xcos);
+                        b[1]=_mm_unpackhi_epi8(xsin,xcos);
+                        for (j=0; j<2; j++) {
+                                d[j]=_mm_loadu_si128((__m128i *)(p+16*j));
+                                if (nv<32) {
+                                        mk=_mm_loadu_si128((__m128i *)(vmask+32-nv+16*j));
+                                        d[j]=_mm_and_si128(d[j],mk);
+                                }
+                                ad[j]=_mm_abs_epi8(d[j]);
+                                a[j]=_mm_sign_epi8(a[j],d[j]);
+                                b[j]=_mm_sign_epi8(b[j],d[j]);
+                        }
+                        for (k=0; k<ntap; k++) {
+                                __m128i c0,c1;
+                                c=code+2*(to[k]+i);
+                                c0=_mm_loadu_si128((__m128i *)c);
+                                c1=_mm_loadu_si128((__m128i *)(c+16));
+                                sumI[k]=_mm_add_epi32(sumI[k],_mm_madd_epi16(
+                                    _mm_add_epi16(
+                                    _mm_maddubs_epi16(ad[0],_mm_sign_epi8(a[0],c0)),
+                                    _mm_maddubs_epi16(ad[1],_mm_sign_epi8(a[1],c1))),
+                                    ones));
+                                sumQ[k]=_mm_add_epi32(sumQ[k],_mm_madd_epi16(
+                                    _mm_add_epi16(
+                                    _mm_maddubs_epi16(ad[0],_mm_sign_epi8(b[0],c0)),
+                                    _mm_maddubs_epi16(ad[1],_mm_sign_epi8(b[1],c1))),
+                                    ones));
+                        }
+                } else { /* real */
+                        d[0]=_mm_loadu_si128((__m128i *)p);
+                        if (nv<16) {
+                                mk=_mm_loadu_si128((__m128i *)(vmask+32-nv));
+                                d[0]=_mm_and_si128(d[0],mk);
+                        }
+                        ad[0]=_mm_abs_epi8(d[0]);
+                        a[0]=_mm_sign_epi8(xcos,d[0]);
+                        b[0]=_mm_sign_epi8(xsin,d[0]);
+                        for (k=0; k<ntap; k++) {
+                                __m128i c0;
+                                c0=_mm_loadu_si128((__m128i *)(code+to[k]+i));
+                                MULADD_INT8(sumI[k],ad[0],_mm_sign_epi8(a[0],c0),ones);
+                                MULADD_INT8(sumQ[k],ad[0],_mm_sign_epi8(b[0],c0),ones);
+                        }
+                }
+        }
+        for (k=0; k<ntap; k++) {
+                _mm_storeu_si128((__m128i *)acc,sumI[k]);
+                II[k]=(acc[0]+acc[1]+acc[2]+acc[3])*CSCALE;
+                _mm_storeu_si128((__m128i *)acc,sumQ[k]);
+                QQ[k]=(acc[0]+acc[1]+acc[2]+acc[3])*CSCALE;
+        }
+}
+/* specialized int8 correlators ------------------------------------------------
+* dot_int8 instances with constant data type, number of correlation points
+* (corrn) and interval of correlation points (corrd). corrn=1 instances also
+* serve as the E/P/L tap set at CORRP.
+*-----------------------------------------------------------------------------*/
+#define DEF_CORR_INT8(name,dtype,corrn,corrd) \
+static void name(const char *data, int n, uint32_t ph, uint32_t step, \
+                 const char *code, double *II, double *QQ) \
+{ \
+        dot_int8(data,dtype,n,ph,step,code,NULL,1+2*(corrn),corrd,II,QQ); \
+}
+#define DEF_CORR_INT8_D(corrn,corrd) \
+        DEF_CORR_INT8(corr_iq_##corrn##_##corrd,DTYPEIQ,corrn,corrd) \
+        DEF_CORR_INT8(corr_i_##corrn##_##corrd ,DTYPEI ,corrn,corrd)
+#define DEF_CORR_INT8_N(corrn) \
+        DEF_CORR_INT8_D(corrn,1) \
+        DEF_CORR_INT8_D(corrn,2) \
+        DEF_CORR_INT8_D(corrn,4)
+DEF_CORR_INT8_N(1)
+DEF_CORR_INT8_D(1,8)
+DEF_CORR_INT8_N(2)
+DEF_CORR_INT8_N(4)
+DEF_CORR_INT8_N(6)
+
+#define CORR_INT8_D(corrn,corrd) \
+        {DTYPEIQ,corrn,corrd,corr_iq_##corrn##_##corrd}, \
+        {DTYPEI ,corrn,corrd,corr_i_##corrn##_##corrd}
+#define CORR_INT8_N(corrn) \
+        CORR_INT8_D(corrn,1),CORR_INT8_D(corrn,2),CORR_INT8_D(corrn,4)
+
+static const struct {
+        int dtype,corrn,corrd;
+        corrfunc_t func;
+} corrfuncs[]={
+        CORR_INT8_N(1),CORR_INT8_D(1,8),
+        CORR_INT8_N(2),CORR_INT8_N(4),CORR_INT8_N(6)
+};
+#endif /* SSE2_ENABLE */
+
+/* get specialized correlator --------------------------------------------------
+* get correlator kernel specialized for data type and correlation points
+* args   : int    dtype     I   sampling data type (1:real,2:complex)
+*          int    corrn     I   number of correlation points (half side)
+*          int    corrd     I   interval of correlation points (sample)
+* return : corrfunc_t           correlator kernel (NULL: generic)
+*-----------------------------------------------------------------------------*/
+extern corrfunc_t getcorrfunc(int dtype, int corrn, int corrd)
+{
+#if defined(SSE2_ENABLE)
+        int i;
+
+        for (i=0; i<(int)(sizeof(corrfuncs)/sizeof(corrfuncs[0])); i++) {
+                if (corrfuncs[i].dtype==dtype&&corrfuncs[i].corrn==corrn&&
+                    corrfuncs[i].corrd==corrd) return corrfuncs[i].func;
+        }
+#endif
+        return NULL;
+}
+
+#if defined(SSE2_ENABLE)
+/* int16 code to int8 (duplicated per byte pair for complex) -----------------*/
+static void codetoint8(const short *code, int n, int dtype, char *code8)
+{
+        __m128i x;
+        int i;
+
+        for (i=0; i<n; i+=16) {
+                x=_mm_packs_epi16(_mm_loadu_si128((__m128i *)(code+i)),
+                                  _mm_loadu_si128((__m128i *)(code+i+8)));
+                if (dtype==DTYPEIQ) {
+                        _mm_storeu_si128((__m128i *)(code8+2*i),_mm_unpacklo_epi8(x,x));
+                        _mm_storeu_si128((__m128i *)(code8+2*i+16),_mm_unpackhi_epi8(x,x));
+                } else {
+                        _mm_storeu_si128((__m128i *)(code8+i),x);
+                }
+        }
+}
+#endif /* SSE2_ENABLE */
+
 /* correlator ------------------------------------------------------------------
 * multiply sampling data and carrier (I/Q), multiply code (E/P/L), and integrate
 * args   : char   *data     I   sampling data vector (n x 1 or 2n x 1)
@@ -1075,13 +1397,18 @@ extern double mixcarr(const char *data, int dtype, double ti, int n,
 *          short  *I,*Q     O   correlation power I,Q
 *                                 I={I_P,I_E1,I_L1,I_E2,I_L2,...,I_Em,I_Lm}
 *                                 Q={Q_P,Q_E1,Q_L1,Q_E2,Q_L2,...,Q_Em,Q_Lm}
+*          double *remc     O   code remainder (chip)
+*          double *remp     O   carrier phase remainder (rad)
+*          short  *codein   I   original code
+*          int    coden     I   code length
+*          corrfunc_t func  I   specialized kernel (getcorrfunc(), NULL: generic)
 * return : none
 * notes  : see above for data
 *-----------------------------------------------------------------------------*/
 extern void correlator(const char *data, int dtype, double ti, int n,
                        double freq, double phi0, double crate, double coff,
                        int* s, int ns, double *II, double *QQ, double *remc,
-                       double *remp, short* codein, int coden)
+                       double *remp, short* codein, int coden, corrfunc_t func)
 {
         short *dataI=NULL,*dataQ=NULL,*code_e=NULL,*code;
         int i;
@@ -1089,6 +1416,36 @@ extern void correlator(const char *data, int dtype, double ti, int n,
 
         //printf("n:%d  ns:%d  s[ns-1]:%d\n",n,ns,s[ns-1]);
 
+#if defined(SSE2_ENABLE)
+        /* int8 path: samples are never widened to int16 */
+        if (1+2*ns<=MAXCORRTAP) {
+                char *code8=NULL;
+                int off[MAXCORRTAP];
+                uint32_t step=freqtoword(freq,ti);
+
+                if (!(code_e=(short *)sdrscratch(0,sizeof(short)*(n+2*smax+16)))||
+                    !(code8=(char *)sdrscratch(1,dtype*(n+2*smax+48)))) {
+                        SDRPRINTF("error: correlator memory allocation\n");
+                        return;
+                }
+                *remc=rescode(codein,coden,coff,smax,ti*crate,n,code_e);
+                codetoint8(code_e,n+2*smax,dtype,code8);
+
+                if (func) {
+                        func(data,n,phasetoword(phi0),step,code8,II,QQ);
+                } else {
+                        off[0]=smax;
+                        for (i=0; i<ns; i++) {
+                                off[1+2*i]=smax-s[i];
+                                off[2+2*i]=smax+s[i];
+                        }
+                        dot_int8(data,dtype,n,phasetoword(phi0),step,code8,off,
+                                 1+2*ns,0,II,QQ);
+                }
+                *remp=wordtophase(phasetoword(phi0)+(uint32_t)n*step);
+                return;
+        }
+#endif
         /* 8 is treatment of remainder in SSE2 */
         if (!(dataI=(short *)sdrmalloc(sizeof(short)*(n+64)))||
             !(dataQ=(short *)sdrmalloc(sizeof(short)*(n+64)))||
@@ -1117,6 +1474,254 @@ extern void correlator(const char *data, int dtype, double ti, int n,
         dataI=dataQ=code_e=NULL;
 }
 
+/* set bits --------------------------------------------------------------------
+* set k bits of bit array w from bit i (LSB first)
+*-----------------------------------------------------------------------------*/
+static void bitset(uint64_t *w, int i, int k)
+{
+        int j=i>>6,b=i&63,m;
+
+        for (; k>0; j++,b=0,k-=m) {
+                m=k<64-b?k:64-b;
+                w[j]|=(m==64?~0ULL:((1ULL<<m)-1))<<b;
+        }
+}
+/* get 64 bits of bit array w from bit i -------------------------------------*/
+static uint64_t bitget(const uint64_t *w, int i)
+{
+        int j=i>>6,b=i&63;
+        return b?(w[j]>>b)|(w[j+1]<<(64-b)):w[j];
+}
+/* carrier sign bits -----------------------------------------------------------
+* sign bits (bit=1: negative) of local carrier cos/sin from nco phase words
+* args   : uint32_t ph      I   initial phase word
+*          uint32_t step    I   phase word increment per sample
+*          int    n         I   number of samples
+*          uint64_t *cc,*ss O   cos/sin sign bits (zero-filled on input)
+* return : uint32_t             phase word of sample n
+* notes  : bits are filled per carrier quadrant, so the cost is proportional to
+*          the number of quadrant changes rather than the number of samples.
+*-----------------------------------------------------------------------------*/
+static uint32_t carrbits(uint32_t ph, uint32_t step, int n, uint64_t *cc,
+                         uint64_t *ss)
+{
+        int32_t st=(int32_t)step;
+        uint32_t o;
+        int i,k,q;
+
+        for (i=0; i<n; i+=k,ph+=(uint32_t)k*step) {
+                q=ph>>30;
+                o=ph&0x3FFFFFFF;
+                if      (st>0) k=(int)((0x40000000ULL-o+st-1)/st);
+                else if (st<0) k=(int)(o/(uint64_t)(-(int64_t)st))+1;
+                else           k=n;
+                if (k>n-i) k=n-i;
+                if (q==1||q==2) bitset(cc,i,k);
+                if (q>=2)       bitset(ss,i,k);
+        }
+        return ph;
+}
+/* code sign bits --------------------------------------------------------------
+* sign bits (bit=1: negative) of resampled code
+* args   : short  *code     I   resampled code (n+16 samples readable)
+*          int    n         I   number of samples
+*          uint64_t *cb     O   code sign bits
+* return : none
+*-----------------------------------------------------------------------------*/
+static void codebits(const short *code, int n, uint64_t *cb)
+{
+        int i;
+#if !defined(SSE2_ENABLE)
+        memset(cb,0,sizeof(uint64_t)*((n+63)/64));
+        for (i=0; i<n; i++) {
+                if (code[i]<0) cb[i>>6]|=1ULL<<(i&63);
+        }
+#else
+        unsigned short *p=(unsigned short *)cb;
+        __m128i xmm1,xmm2;
+
+        for (i=0; i<n; i+=16,p++) {
+                xmm1=_mm_loadu_si128((__m128i *)(code+i));
+                xmm2=_mm_loadu_si128((__m128i *)(code+i+8));
+                *p=(unsigned short)_mm_movemask_epi8(_mm_packs_epi16(xmm1,xmm2));
+        }
+#endif
+}
+/* pack sampling data to bit planes --------------------------------------------
+* quantize sampling data to sign (and magnitude) bit planes
+* args   : char   *data     I   sampling data vector (n x 1 or 2n x 1)
+*          int    dtype     I   sampling data type (1:real,2:complex)
+*          int    n         I   number of samples
+*          int    quant     I   quantization (1:1bit sign,2:2bit sign/magnitude)
+*          uint64_t *sI,*sQ O   I/Q sign planes (bit=1: negative)
+*          uint64_t *mI,*mQ O   I/Q magnitude planes (bit=1: |x|>threshold)
+* return : double               mean absolute value of samples
+* notes  : planes are (n+15)/16*16 bits. the magnitude threshold is 1.25 x mean
+*          absolute value (about 1 sigma for gaussian noise). sQ/mQ are not
+*          used for real data, mI/mQ are not used for 1bit.
+*-----------------------------------------------------------------------------*/
+extern double packbits(const char *data, int dtype, int n, int quant,
+                       uint64_t *sI, uint64_t *sQ, uint64_t *mI, uint64_t *mQ)
+{
+        int i,thres,x,y;
+        long sum=0;
+
+#if !defined(SSE2_ENABLE)
+        int nw=(n+63)/64;
+
+        for (i=0; i<n*dtype; i++) sum+=abs(data[i]);
+        thres=(int)(1.25*sum/(n*dtype)+0.5);
+
+        memset(sI,0,sizeof(uint64_t)*nw);
+        memset(mI,0,sizeof(uint64_t)*nw);
+        if (dtype==DTYPEIQ) {
+                memset(sQ,0,sizeof(uint64_t)*nw);
+                memset(mQ,0,sizeof(uint64_t)*nw);
+        }
+        for (i=0; i<n; i++) {
+                x=data[i*dtype];
+                if (x<0) sI[i>>6]|=1ULL<<(i&63);
+                if (quant==2&&abs(x)>thres) mI[i>>6]|=1ULL<<(i&63);
+                if (dtype==DTYPEIQ) {
+                        y=data[i*2+1];
+                        if (y<0) sQ[i>>6]|=1ULL<<(i&63);
+                        if (quant==2&&abs(y)>thres) mQ[i>>6]|=1ULL<<(i&63);
+                }
+        }
+#else
+        unsigned short *psI=(unsigned short *)sI,*psQ=(unsigned short *)sQ;
+        unsigned short *pmI=(unsigned short *)mI,*pmQ=(unsigned short *)mQ;
+        const char *p;
+        __m128i xmm1,xmm2,xacc,xthr,zero=_mm_setzero_si128();
+        __m128i deint=_mm_setr_epi8(0,2,4,6,8,10,12,14,1,3,5,7,9,11,13,15);
+
+        /* mean absolute value */
+        xacc=zero;
+        for (i=0; i+16<=n*dtype; i+=16) {
+                xmm1=_mm_abs_epi8(_mm_loadu_si128((__m128i *)(data+i)));
+                xacc=_mm_add_epi64(xacc,_mm_sad_epu8(xmm1,zero));
+        }
+        sum=_mm_cvtsi128_si32(xacc)+_mm_cvtsi128_si32(_mm_srli_si128(xacc,8));
+        for (; i<n*dtype; i++) sum+=abs(data[i]);
+        thres=(int)(1.25*sum/(n*dtype)+0.5);
+        xthr=_mm_set1_epi8((char)(thres<127?thres:127));
+
+        for (i=0,p=data; i<n; i+=16,p+=16*dtype) {
+                if (dtype==DTYPEIQ) {
+                        xmm1=_mm_shuffle_epi8(_mm_loadu_si128((__m128i *)p),deint);
+                        xmm2=_mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(p+16)),deint);
+                        x=_mm_movemask_epi8(_mm_unpacklo_epi64(xmm1,xmm2));
+                        y=_mm_movemask_epi8(_mm_unpackhi_epi64(xmm1,xmm2));
+                        *psI++=(unsigned short)x;
+                        *psQ++=(unsigned short)y;
+                        if (quant==2) {
+                                *pmI++=(unsigned short)_mm_movemask_epi8(
+                                    _mm_cmpgt_epi8(_mm_abs_epi8(
+                                    _mm_unpacklo_epi64(xmm1,xmm2)),xthr));
+                                *pmQ++=(unsigned short)_mm_movemask_epi8(
+                                    _mm_cmpgt_epi8(_mm_abs_epi8(
+                                    _mm_unpackhi_epi64(xmm1,xmm2)),xthr));
+                        }
+                } else {
+                        xmm1=_mm_loadu_si128((__m128i *)p);
+                        *psI++=(unsigned short)_mm_movemask_epi8(xmm1);
+                        if (quant==2) {
+                                *pmI++=(unsigned short)_mm_movemask_epi8(
+                                    _mm_cmpgt_epi8(_mm_abs_epi8(xmm1),xthr));
+                        }
+                }
+        }
+#endif
+        return (double)sum/(n*dtype);
+}
+/* bit correlator --------------------------------------------------------------
+* correlator for 1bit/2bit quantized data using xor and popcount
+* args   : (same as correlator)
+*          int    quant     I   quantization (1:1bit sign,2:2bit sign/magnitude)
+* return : none
+* notes  : sampling data is packed to sign (and magnitude) bit planes and the
+*          local carrier is reduced to its sign. each tap is computed 64
+*          samples at a time as n-2*popcount(data^carrier^code). outputs are
+*          scaled to the same amplitude as correlator().
+*-----------------------------------------------------------------------------*/
+extern void bcorrelator(const char *data, int dtype, double ti, int n,
+                        double freq, double phi0, double crate, double coff,
+                        int* s, int ns, double *II, double *QQ, double *remc,
+                        double *remp, short* codein, int coden, int quant)
+{
+        uint64_t *buff=NULL,*sI,*sQ,*mI,*mQ,*cc,*ss,*cb,*x[4],*m[4];
+        uint64_t w,v,t,tail;
+        short *code_e=NULL;
+        uint32_t ph=phasetoword(phi0),step=freqtoword(freq,ti);
+        int i,j,k,np=dtype==DTYPEIQ?4:2,smax=s[ns-1],off;
+        int nw=(n+63)/64,ncw=(n+2*smax+16+63)/64+1;
+        long cnt[4],cntm[4],nm[4]={0};
+        double mean,unit,S[4];
+
+        if (!(buff=(uint64_t *)sdrscratch(2,sizeof(uint64_t)*(10*nw+ncw)))||
+            !(code_e=(short *)sdrscratch(0,sizeof(short)*(n+2*smax+16)))) {
+                SDRPRINTF("error: bcorrelator memory allocation\n");
+                return;
+        }
+        memset(buff,0,sizeof(uint64_t)*(10*nw+ncw));
+        sI=buff; sQ=sI+nw; mI=sQ+nw; mQ=mI+nw; cc=mQ+nw; ss=cc+nw;
+        x[0]=ss+nw; x[1]=x[0]+nw; x[2]=x[1]+nw; x[3]=x[2]+nw; cb=x[3]+nw;
+        tail=n%64?(1ULL<<(n%64))-1:~0ULL;
+
+        /* pack data, carrier and code */
+        mean=packbits(data,dtype,n,quant,sI,sQ,mI,mQ);
+        ph=carrbits(ph,step,n,cc,ss);
+        *remp=wordtophase(ph);
+        *remc=rescode(codein,coden,coff,smax,ti*crate,n,code_e);
+        codebits(code_e,n+2*smax,cb);
+
+        /* data x carrier: cos*I, sin*I, sin*Q, cos*Q */
+        mI[nw-1]&=tail; mQ[nw-1]&=tail;
+        m[0]=m[1]=mI; m[2]=m[3]=mQ;
+        for (j=0; j<nw; j++) {
+                x[0][j]=cc[j]^sI[j];
+                x[1][j]=ss[j]^sI[j];
+                x[2][j]=ss[j]^sQ[j];
+                x[3][j]=cc[j]^sQ[j];
+        }
+        if (quant==2) {
+                for (j=0; j<nw; j++) {
+                        nm[0]+=__builtin_popcountll(mI[j]);
+                        nm[2]+=__builtin_popcountll(mQ[j]);
+                }
+                nm[1]=nm[0]; nm[3]=nm[2];
+        }
+        /* level unit (1bit: +-1, 2bit: +-1/+-3) and sign carrier gain (pi/4) */
+        unit=mean/(1.0+2.0*(nm[0]+nm[2])/(n*dtype))*PI/4.0;
+
+        /* multiply code and integrate: P,E1,L1,...,Em,Lm */
+        for (k=0; k<1+2*ns; k++) {
+                off=smax+(k==0?0:(k%2?-s[(k-1)/2]:s[(k-1)/2]));
+                memset(cnt,0,sizeof(cnt));
+                memset(cntm,0,sizeof(cntm));
+                for (j=0; j<nw; j++) {
+                        w=bitget(cb,off+64*j);
+                        v=j<nw-1?~0ULL:tail;
+                        for (i=0; i<np; i++) {
+                                t=(x[i][j]^w)&v;
+                                cnt[i]+=__builtin_popcountll(t);
+                                if (quant==2) cntm[i]+=__builtin_popcountll(t&m[i][j]);
+                        }
+                }
+                for (i=0; i<np; i++) {
+                        S[i]=(double)(n-2*cnt[i]);
+                        if (quant==2) S[i]+=2.0*(nm[i]-2*cntm[i]);
+                }
+                if (dtype==DTYPEIQ) {
+                        II[k]=(S[0]-S[2])*unit;
+                        QQ[k]=(S[1]+S[3])*unit;
+                } else {
+                        II[k]=S[0]*unit;
+                        QQ[k]=S[1]*unit;
+                }
+        }
+}
+
 /* parallel correlator ---------------------------------------------------------
 * fft based parallel correlator
 * args   : char   *data     I   sampling data vector (n x 1 or 2n x 1)
@@ -0,0 +1,178 @@
+//-----------------------------------------------------------------------------
+// sdrdaemon.c : headless mode (no ncurses, signal driven, status log)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+#define LOGTICKMS     100              // log thread tick (elapsed time, msgs)
+
+static FILE *logfp=NULL;           // status log ([DAEMON] LOG, NULL: stderr)
+static int logreopen=0;            // reopen request (SIGHUP)
+static thread_t hlogthread;        // status log thread
+
+// block shutdown signals ------------------------------------------------------
+// block SIGTERM/SIGINT/SIGHUP in the calling thread before any other thread
+// is created: all threads inherit the mask and only daemonrun() receives the
+// signals (sigwait)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void daemonsignals(void)
+{
+    sigset_t set;
+
+    sigemptyset(&set);
+    sigaddset(&set,SIGTERM);
+    sigaddset(&set,SIGINT);
+    sigaddset(&set,SIGHUP);
+    pthread_sigmask(SIG_BLOCK,&set,NULL);
+}
+
+// open status log -------------------------------------------------------------
+static void logopen(void)
+{
+    if (logfp) fclose(logfp);
+    logfp=NULL;
+    if (!sdrini.statuslog[0]) return;
+    if (!(logfp=fopen(sdrini.statuslog,"a"))) {
+        fprintf(stderr,"error: status log %s\n",sdrini.statuslog);
+    }
+}
+
+// status line -----------------------------------------------------------------
+// solution and channel states from the navigation snapshot and relaxed loads
+static void logstatus(FILE *fp)
+{
+    sdrnavsnap_t snap;
+    double cn0;
+    char sat[sizeof(sdrch[0].satstr)];
+    int i;
+
+    getnavsnap(&snap);
+    fprintf(fp,"%.3f  status: sats %d pos %.6f %.6f %.1f gdop %.2f load "
+        "%.0f%% shed %d |",sdrstat.elapsedTime,snap.nsatValid,snap.lat,snap.lon,
+        snap.hgt,snap.gdop,sdrstat.load*100.0,
+        __atomic_load_n(&sdrstat.shed,__ATOMIC_RELAXED));
+    for (i=0;i<sdrini.nch;i++) {
+        if (!__atomic_load_n(&sdrch[i].flagacq,__ATOMIC_RELAXED)) continue;
+        memcpy(sat,sdrch[i].satstr,sizeof(sat)); // G01, SBAS 120
+        sat[sizeof(sat)-1]='\0';
+        __atomic_load(&sdrch[i].trk.cn0,&cn0,__ATOMIC_RELAXED);
+        fprintf(fp," %s %.0f%s",sat,cn0,
+            __atomic_load_n(&sdrch[i].trk.flaglock,__ATOMIC_RELAXED)?"":"?");
+    }
+    fprintf(fp,"\n");
+}
+
+// new program messages --------------------------------------------------------
+// write the messages posted since the last call (add_message)
+static void logmessages(FILE *fp, uint64_t *last)
+{
+    uint64_t total=__atomic_load_n(&sdrgui.message_total,__ATOMIC_RELAXED),n;
+    int i;
+
+    if (total==*last) return;
+
+    mlock(hmsgmtx);
+    total=sdrgui.message_total;
+    n=total-*last;
+    if (n>(uint64_t)sdrgui.message_count) n=sdrgui.message_count;
+    for (i=sdrgui.message_count-(int)n;i<sdrgui.message_count;i++) {
+        fprintf(fp,"%s\n",sdrgui.messages[i]);
+    }
+    unmlock(hmsgmtx);
+    *last=total;
+}
+
+// status log thread -----------------------------------------------------------
+// replaces the GUI loop: elapsed time, program messages and a status line
+// every [DAEMON] STATUSMS (0: messages only)
+static void *logthread(void *arg)
+{
+    struct timespec t0,t;
+    uint64_t last=0;
+    unsigned long tick,tstat=0;
+    FILE *fp;
+
+    schedrole(ROLE_GUI);
+    probethread("sdr-log");
+
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    sdrstat.elapsedTime=0.0;
+
+    while (!sdrstat.stopflag) {
+        sleepms(LOGTICKMS);
+
+        clock_gettime(CLOCK_MONOTONIC,&t);
+        sdrstat.elapsedTime=(t.tv_sec-t0.tv_sec)+(t.tv_nsec-t0.tv_nsec)*1E-9;
+
+        fp=logfp?logfp:stderr;
+        if (__atomic_exchange_n(&logreopen,0,__ATOMIC_RELAXED)) {
+            logopen();
+            fp=logfp?logfp:stderr;
+            logstatus(fp);
+        }
+
+        evdrain();
+        logmessages(fp,&last);
+        tick=(unsigned long)(sdrstat.elapsedTime*1000.0);
+        if (sdrini.statusms>0&&tick-tstat>=(unsigned long)sdrini.statusms) {
+            logstatus(fp);
+            tstat=tick;
+        }
+        fflush(fp);
+    }
+    fp=logfp?logfp:stderr;
+    evdrain();
+    logmessages(fp,&last);
+    logstatus(fp);
+    fflush(fp);
+
+    // wake daemonrun() if the receiver stopped by itself (end of file)
+    pthread_kill(hmainthread,SIGTERM);
+    return THRETVAL;
+}
+
+// run headless ----------------------------------------------------------------
+// main thread of the headless mode: start the status log thread and sleep in
+// sigwait() (no periodic work). SIGTERM/SIGINT: stop the receiver, SIGHUP:
+// reopen the status log (log rotation) and log the status. returns when the
+// receiver is stopping.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void daemonrun(void)
+{
+    sigset_t set;
+    int sig;
+
+    sigemptyset(&set);
+    sigaddset(&set,SIGTERM);
+    sigaddset(&set,SIGINT);
+    sigaddset(&set,SIGHUP);
+
+    hmainthread=pthread_self();
+    logopen();
+    if (pthread_create(&hlogthread,NULL,logthread,NULL)) {
+        fprintf(stderr,"error: status log thread\n");
+        sdrstat.stopflag=ON;
+        return;
+    }
+    while (!sdrstat.stopflag) {
+        if (sigwait(&set,&sig)) continue;
+
+        if (sig==SIGHUP) {
+            __atomic_store_n(&logreopen,1,__ATOMIC_RELAXED);
+            add_messagef("SIGHUP: status log reopened");
+            continue;
+        }
+        if (!sdrstat.stopflag) {
+            add_messagef("%s: stopping",sig==SIGINT?"SIGINT":"SIGTERM");
+        }
+        sdrstat.stopflag=ON;
+    }
+    waitthread(hlogthread);
+    if (logfp) fclose(logfp);
+    logfp=NULL;
+}
@@ -0,0 +1,239 @@
+//-----------------------------------------------------------------------------
+// sdrevent.c : event log (binary records, formatted by the consumer)
+//
+// the real-time threads log an event id, the elapsed time and up to four
+// numbers into a ring of their own (no lock, no formatting, no allocation).
+// the GUI loop or the headless status log thread formats the records in time
+// order into the program messages (evdrain()). a full ring drops the record
+// and counts it, the count is reported as a message.
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+#define MAXEVTHREAD   128              // max logging threads
+#define EVRING        1024             // records per thread ring (power of 2)
+
+// event formats (elapsed time first, then the numbers of the record). %P
+// prints a PRN number as the satellite id (G01, SBAS 120), see evformat()
+static const char *evfmt[EVENTS]={
+    [EV_CATCHUP]  ="%.3f  %P catch-up, backlog %.0f ms (%+.0f ms/s)",
+    [EV_CAUGHTUP] ="%.3f  %P caught up, backlog %.0f ms",
+    [EV_OVERRUN]  ="%.3f  %P ring buffer overrun, backlog %.0f ms (slot overrun "
+                   "%.0f), reacquiring",
+    [EV_LOSTLOCK] ="%.3f  %P lost lock (C/N0 %.1f, PLI %.2f), reacquiring",
+    [EV_NOLOCK]   ="%.3f  %P no lock after acquisition (C/N0 %.1f, PLI "
+                   "%.2f), reacquiring",
+    [EV_RESETNAV] ="%.3f  %P resetting, flagdec:%.0f, flagsync:%.0f, "
+                   "Week:%.0f",
+    [EV_RESETEL]  ="%.3f  %P resetting, SV el: %.1f",
+    [EV_RESET]    ="%.3f  resetStructs: %P channel has been reset, slot "
+                   "%.0f acquires %P",
+    [EV_RESETERR] ="%.3f  resetStructs: error",
+    [EV_OBSDELAY] ="%.3f  checkObsDelay: resetting %P due to mismatch",
+    [EV_SLOTREL+SLOT_ACQFAIL]="%.3f  slot %.0f: %P released (acq failed, "
+                   "retry in %.0fs), next %P",
+    [EV_SLOTREL+SLOT_LOST]="%.3f  slot %.0f: %P released (lost, retry in "
+                   "%.0fs), next %P",
+    [EV_SLOTREL+SLOT_LOWEL]="%.3f  slot %.0f: %P released (low el, retry "
+                   "in %.0fs), next %P",
+    [EV_SLOTREL+SLOT_SHED]="%.3f  slot %.0f: %P released (shed, retry in "
+                   "%.0fs), next %P",
+    [EV_PVTERR]   ="%.3f  errorDetected: exiting pvtProcessor",
+    [EV_PVTFEW]   ="%.3f  pvtProcessor: PVT not solved for, less than four SVs",
+    [EV_SATPOSNAN]="%.3f  Function satPos has xs NaN for %P, exiting "
+                   "pvtProcessor",
+    [EV_NOEKF]    ="%.3f  Error, EKF not installed.",
+    [EV_POSNAN]   ="%.3f  Function estRcvrPosn gets NaN for xu, exiting "
+                   "pvtProcessor",
+    [EV_DET]      ="%.3f  Exiting estRcvrPosn, determinant=%f",
+    [EV_TOPOCENT] ="%.3f  topocent function: error",
+    [EV_TROPO]    ="%.3f  tropo function: error",
+    [EV_TOGEODIT] ="%.3f  Problem in TOGEOD, did not converge in %2.0f "
+                   "iterations",
+    [EV_TOGEOD]   ="%.3f  togeod function: error",
+    [EV_PRESNR]   ="%.3f  preCheckObs: %P has SNR:%.1f",
+    [EV_PREWEEK]  ="%.3f  preCheckObs: %P has Week:%.0f",
+    [EV_PRETOW]   ="%.3f  preCheckObs: %P has ToW:%.1f",
+    [EV_PRELOWPR] ="%.3f  preCheckObs: %P has Low PR:%.1f",
+    [EV_PREHIGHPR]="%.3f  preCheckObs: %P has High PR:%.1f",
+    [EV_PREEPH]   ="%.3f  precheckEPH: %P tagged for removal for eph error",
+    [EV_PREEL]    ="%.3f  precheckObs: %P tagged for removal with el of "
+                   "%.1f",
+    [EV_OBSLIST]  ="%.3f  updateObsList: error"
+};
+
+// event record
+typedef struct {
+        double t;        // elapsed time (s)
+        int id;          // event id (EV_???)
+        double a[4];     // numbers
+} evrec_t;
+
+// per thread ring (single producer: the thread, consumer: evdrain())
+typedef struct {
+        unsigned int head __attribute__((aligned(CACHELINE))); // next write
+        unsigned int tail __attribute__((aligned(CACHELINE))); // next read
+        uint64_t drop;   // records dropped (ring full)
+        uint64_t dropmsg; // drops reported (consumer)
+        char name[16];   // thread name
+        evrec_t rec[EVRING]; // records
+} evring_t;
+
+static evring_t *evring[MAXEVTHREAD]; // thread rings
+static int nevring=0;               // number of thread rings
+static uint64_t evnoring=0;         // records of threads without a ring
+static uint64_t evnoringmsg=0;      // ringless drops reported (consumer)
+static __thread evring_t *myring=NULL; // ring of the calling thread
+static pthread_mutex_t hevmtx=PTHREAD_MUTEX_INITIALIZER; // consumers
+
+// format event record ---------------------------------------------------------
+// printf conversions of the format take the elapsed time and the numbers in
+// order (one double each), %P takes a PRN number and prints the satellite id
+static void evformat(char *msg, int size, const char *fmt, const evrec_t *e)
+{
+    const double v[5]={e->t,e->a[0],e->a[1],e->a[2],e->a[3]};
+    char spec[16];
+    int n=0,k=0,m,prn;
+
+    while (*fmt&&n<size-1) {
+        if (*fmt!='%') {
+            msg[n++]=*fmt++;
+            continue;
+        }
+        if (fmt[1]=='%') {
+            msg[n++]='%';
+            fmt+=2;
+            continue;
+        }
+        // conversion spec (flags, width, precision and the conversion)
+        for (m=1;fmt[m]&&strchr("-+ #0123456789.",fmt[m]);m++) ;
+        if (!fmt[m]||m>=(int)sizeof(spec)-1||k>=5) break;
+        memcpy(spec,fmt,m+1);
+        spec[m+1]='\0';
+        fmt+=m+1;
+        if (spec[m]=='P') {
+            prn=(int)v[k++];
+            if (prn>=MINPRNSBS&&prn<=MAXPRNSBS) {
+                m=snprintf(msg+n,size-n,"%03d",prn);
+            } else {
+                m=snprintf(msg+n,size-n,"G%02d",prn);
+            }
+        } else {
+            m=snprintf(msg+n,size-n,spec,v[k++]);
+        }
+        if (m<0) break;
+        n+=m<size-n?m:size-1-n;
+    }
+    msg[n]='\0';
+}
+
+// thread ring -----------------------------------------------------------------
+static evring_t *getring(void)
+{
+    evring_t *r;
+    int i;
+
+    if (myring) return myring;
+    if (__atomic_load_n(&nevring,__ATOMIC_RELAXED)>=MAXEVTHREAD) return NULL;
+    if (posix_memalign((void **)&r,CACHELINE,sizeof(evring_t))) return NULL;
+    memset(r,0,sizeof(evring_t));
+    if (pthread_getname_np(pthread_self(),r->name,sizeof(r->name))) {
+        strcpy(r->name,"?");
+    }
+    if ((i=__atomic_fetch_add(&nevring,1,__ATOMIC_RELAXED))>=MAXEVTHREAD) {
+        free(r);
+        return NULL;
+    }
+    __atomic_store_n(&evring[i],r,__ATOMIC_RELEASE);
+    return myring=r;
+}
+
+// log event -------------------------------------------------------------------
+// write an event record to the ring of the calling thread (no lock, the text
+// is formatted later by evdrain()). unused numbers are 0.
+// args   : int    id        I   event id (EV_???)
+//          double a0..a3    I   numbers of the event format
+// return : none
+//-----------------------------------------------------------------------------
+extern void evlog(int id, double a0, double a1, double a2, double a3)
+{
+    evring_t *r=getring();
+    evrec_t *e;
+    unsigned int h;
+
+    if (!r) {
+        __atomic_add_fetch(&evnoring,1,__ATOMIC_RELAXED);
+        return;
+    }
+    h=r->head;
+    if (h-__atomic_load_n(&r->tail,__ATOMIC_ACQUIRE)>=EVRING) {
+        __atomic_store_n(&r->drop,r->drop+1,__ATOMIC_RELAXED);
+        return;
+    }
+    e=&r->rec[h&(EVRING-1)];
+    e->t=sdrstat.elapsedTime;
+    e->id=id;
+    e->a[0]=a0; e->a[1]=a1; e->a[2]=a2; e->a[3]=a3;
+    __atomic_store_n(&r->head,h+1,__ATOMIC_RELEASE);
+}
+
+// format events ---------------------------------------------------------------
+// format the logged events of all threads in time order into the program
+// messages (add_message) and report dropped records. called by the GUI loop
+// or the headless status log thread and once at shutdown.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void evdrain(void)
+{
+    unsigned int head[MAXEVTHREAD];
+    char msg[MSG_LENGTH];
+    evring_t *r;
+    evrec_t *e;
+    uint64_t drop;
+    int i,j,n;
+
+    pthread_mutex_lock(&hevmtx);
+
+    n=__atomic_load_n(&nevring,__ATOMIC_ACQUIRE);
+    if (n>MAXEVTHREAD) n=MAXEVTHREAD;
+    for (i=0;i<n;i++) {
+        r=__atomic_load_n(&evring[i],__ATOMIC_ACQUIRE);
+        head[i]=r?__atomic_load_n(&r->head,__ATOMIC_ACQUIRE):0;
+    }
+    // merge the rings by time (records of one thread stay in order)
+    for (;;) {
+        for (i=0,j=-1;i<n;i++) {
+            if (!(r=evring[i])||r->tail==head[i]) continue;
+            if (j<0||r->rec[r->tail&(EVRING-1)].t<
+                     evring[j]->rec[evring[j]->tail&(EVRING-1)].t) j=i;
+        }
+        if (j<0) break;
+        r=evring[j];
+        e=&r->rec[r->tail&(EVRING-1)];
+        if (e->id>=0&&e->id<EVENTS&&evfmt[e->id]) {
+            evformat(msg,sizeof(msg),evfmt[e->id],e);
+            add_message(msg);
+        }
+        __atomic_store_n(&r->tail,r->tail+1,__ATOMIC_RELEASE);
+    }
+    // dropped records (never silent)
+    for (i=0;i<n;i++) {
+        if (!(r=evring[i])) continue;
+        drop=__atomic_load_n(&r->drop,__ATOMIC_RELAXED);
+        if (drop==r->dropmsg) continue;
+        snprintf(msg,sizeof(msg),"%.3f  event log: %llu events of %s dropped",
+            sdrstat.elapsedTime,(unsigned long long)(drop-r->dropmsg),r->name);
+        add_message(msg);
+        r->dropmsg=drop;
+    }
+    drop=__atomic_load_n(&evnoring,__ATOMIC_RELAXED);
+    if (drop!=evnoringmsg) {
+        snprintf(msg,sizeof(msg),"%.3f  event log: %llu events dropped (no "
+            "ring)",sdrstat.elapsedTime,(unsigned long long)(drop-evnoringmsg));
+        add_message(msg);
+        evnoringmsg=drop;
+    }
+    pthread_mutex_unlock(&hevmtx);
+}
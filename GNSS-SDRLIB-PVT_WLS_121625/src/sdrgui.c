@@ -13,7 +13,7 @@
 
 extern void add_message(const char *msg)
 {
-  pthread_mutex_lock(&hmsgmtx);
+  mlock(hmsgmtx);
   if (sdrgui.message_count < MAX_MESSAGES) {
       sdrgui.messages[sdrgui.message_count++] = strdup(msg);
   } else {
@@ -23,7 +23,23 @@ extern void add_message(const char *msg)
     }
       sdrgui.messages[MAX_MESSAGES - 1] = strdup(msg);
   }
-  pthread_mutex_unlock(&hmsgmtx);
+  sdrgui.message_total++;
+  unmlock(hmsgmtx);
+}
+
+// Formatted message (prefixed with the elapsed time) for the non real-time
+// threads, the real-time threads log events instead (evlog(), sdrevent.c)
+extern void add_messagef(const char *fmt, ...)
+{
+  char msg[MSG_LENGTH];
+  va_list ap;
+  int n;
+
+  n = snprintf(msg, sizeof(msg), "%.3f  ", sdrstat.elapsedTime);
+  va_start(ap, fmt);
+  vsnprintf(msg + n, sizeof(msg) - n, fmt, ap);
+  va_end(ap);
+  add_message(msg);
 }
 
 /*
@@ -50,45 +66,41 @@ extern void updateNavStatusWin(WINDOW *win1, int counter)
   int flagacq[32] = {0};
   int flagsync[32] = {0};
   int flagdec[32] = {0};
+  int flagcatchup[32] = {0};
+  double backlog[32] = {0.0};
   int nsat = 0;
   double lat = 0.0;
   double lon = 0.0;
   double hgt = 0.0;
   double gdop = 0.0;
   double clkBias = 0.0;
-  double obs_v[MAXSAT*11] = {0.0};
-  double vk1_v[MAXSAT] = {0.0};
-  double rk1_v[MAXSAT] = {0.0};
+  sdrnavsnap_t snap;
   int gps_week;
   double gps_tow;
   char bufferNav[256];
-  char str1[10];
+  char str1[24];
 
-  // Load in data to display
-  mlock(hobsvecmtx);
+  // Load in data to display (navigation status snapshot, lock free)
   for (int i=0; i<32; i++) {
     prn[i] = sdrch[i].prn;
     flagacq[i] = sdrch[i].flagacq;
     flagsync[i] = sdrch[i].nav.flagsync;
     flagdec[i] = sdrch[i].nav.flagdec;
+    flagcatchup[i] = sdrch[i].trk.flagcatchup;
+    backlog[i] = sdrch[i].trk.backlog;
   }
-  nsat = sdrstat.nsatValid;
-  lat = sdrstat.lat;
-  lon = sdrstat.lon;
-  hgt = sdrstat.hgt;
-  gdop = sdrstat.gdop;
-  clkBias = sdrstat.xyzdt[3];
-  int numIter = 32*11;
-  for (int m=0; m<numIter; m++) {
-    obs_v[m] = sdrstat.obs_v[m];
-  }
-  for (int n=0; n<32; n++) {
-    vk1_v[n] = sdrstat.vk1_v[n];
-    rk1_v[n] = sdrekf.rk1_v[n];
-  }
-  gps_tow = sdrstat.obs_v[(sdrstat.obsValidList[0]-1)*11+6] ;
-  gps_week = (int)sdrstat.obs_v[(sdrstat.obsValidList[0]-1)*11+7];
-  unmlock(hobsvecmtx);
+  getnavsnap(&snap);
+  nsat = snap.nsatValid;
+  lat = snap.lat;
+  lon = snap.lon;
+  hgt = snap.hgt;
+  gdop = snap.gdop;
+  clkBias = snap.xyzdt[3];
+  double *obs_v = snap.obs_v;
+  double *vk1_v = snap.vk1_v;
+  double *rk1_v = snap.rk1_v;
+  gps_tow = obs_v[(snap.obsValidList[0]-1)*11+6] ;
+  gps_week = (int)obs_v[(snap.obsValidList[0]-1)*11+7];
 
   // Correct rcvr TOW with rcvr clock bias for precise UTC
   time_t utc_time_seconds = gps_to_utc(gps_week, gps_tow+clkBias/CTIME);
@@ -117,6 +129,10 @@ extern void updateNavStatusWin(WINDOW *win1, int counter)
     mvwprintw(win1, 1, 70, "Filter Mode: Least Squares (WLS)");
   }
 
+  // Update channel cpu load and load shedding level (supervisor)
+  mvwprintw(win1, 2, 70, "CPU Load: %3.0f%%  Shed Level: %d",
+    sdrstat.load*100.0, sdrstat.shed);
+
   // Update acquired SVs
   sprintf(bufferNav, "Acquired SVs:   ");
   for (int i=0; i<32; i++) {
@@ -147,6 +163,20 @@ extern void updateNavStatusWin(WINDOW *win1, int counter)
   }
   mvwprintw(win1, 6, 2, "%s", bufferNav);
 
+  // Update SVs in catch-up mode with their backlog
+  sprintf(bufferNav, "Catch-up SVs:   ");
+  for (int i=0; i<32; i++) {
+    if (flagcatchup[i] && strlen(bufferNav)<sizeof(bufferNav)-16) {
+      sprintf(str1, "%02d(%.0fms) ", prn[i], backlog[i]);
+      strcat(bufferNav, str1);
+    }
+  }
+  mvwprintw(win1, 7, 2, "%s", bufferNav);
+
+  // Update stage latencies (p50/p99/max)
+  probeline(bufferNav, sizeof(bufferNav));
+  mvwprintw(win1, 9, 2, "%s", bufferNav);
+
   // Update LLA data
   sprintf(bufferNav, "Lat: %.7f  Lon: %.7f  Alt: %.1f  GDOP: %.2f  CB: %.5e  SVs: %02d",
   lat, lon, hgt, gdop, clkBias/CTIME, nsat);
@@ -154,7 +184,7 @@ extern void updateNavStatusWin(WINDOW *win1, int counter)
 
   // Display Obs data for all valid SVs once it is calculated
   for (int i=0; i<nsat; i++) {
-    int prn = sdrstat.obsValidList[i];
+    int prn = snap.obsValidList[i];
     sprintf(bufferNav, "G%02d  TOW=%.1f  Week=%d  SNR=%.1f  PR=%.1f  Az = %05.1f  EL=%04.1f  rk1=%05.1f  vk1=%7.1f",
       (int)obs_v[(prn-1)*11+0],
       obs_v[(prn-1)*11+6],
@@ -174,7 +204,7 @@ extern void updateNavStatusWin(WINDOW *win1, int counter)
 
 extern void updateProgramStatusWin(WINDOW *win2, int hgt2)
 {
-  pthread_mutex_lock(&hmsgmtx);
+  mlock(hmsgmtx);
 
   // Clear win, add messages, draw a boundary box, and label
   werase(win2);
@@ -188,6 +218,6 @@ extern void updateProgramStatusWin(WINDOW *win2, int hgt2)
   mvwprintw(win2, 0, 5, " Program Status ");
   wattroff(win2,A_BOLD);
 
-  pthread_mutex_unlock(&hmsgmtx);
+  unmlock(hmsgmtx);
   wrefresh(win2);
 }
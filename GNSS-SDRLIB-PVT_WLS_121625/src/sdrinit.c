@@ -97,6 +97,30 @@ void readinistr(char *file, char *sec, char *key, char *out)
     GetPrivateProfileString(sec,key,"",out,256,file);
 }
 
+// read thread role placement -------------------------------------------------
+static void readinirole(char *file, const char *name, sdrrole_t *role)
+{
+    char key[32],str[256],pol[32]="";
+
+    sprintf(key,"%sCPUS",name);
+    readinistr(file,"THREADS",key,role->cpus);
+
+    sprintf(key,"%sSCHED",name);
+    readinistr(file,"THREADS",key,str);
+    sscanf(str,"%31s",pol);
+    if      (!pol[0]||!strcmp(pol,"OTHER")) role->policy=SCHED_OTHER;
+    else if (!strcmp(pol,"FIFO"))           role->policy=SCHED_FIFO;
+    else if (!strcmp(pol,"RR"))             role->policy=SCHED_RR;
+    else role->policy=-1;
+
+    sprintf(key,"%sPRIO",name);
+    role->prio=readiniint(file,"THREADS",key);
+
+    sprintf(key,"%sNODE",name);
+    readinistr(file,"THREADS",key,str);
+    if (sscanf(str,"%d",&role->node)!=1) role->node=-1;
+}
+
 // read ini file --------------------------------------------------------------
 //read ini file and set value to sdrini struct
 //args   : sdrini_t *ini    I/0 sdrini struct
@@ -170,6 +194,7 @@ extern int readinifile(sdrini_t *ini)
     ini->trkcorrn=readiniint(fendfile,"TRACK","CORRN");
     ini->trkcorrd=readiniint(fendfile,"TRACK","CORRD");
     ini->trkcorrp=readiniint(fendfile,"TRACK","CORRP");
+    ini->trkquant=readiniint(fendfile,"TRACK","QUANT");
     ini->trkdllb[0]=readinidouble(fendfile,"TRACK","DLLB1");
     ini->trkpllb[0]=readinidouble(fendfile,"TRACK","PLLB1");
     ini->trkfllb[0]=readinidouble(fendfile,"TRACK","FLLB1");
@@ -180,7 +205,7 @@ extern int readinifile(sdrini_t *ini)
     // Read in gnss-sdrcli.ini file
     // Channel setting
     ini->nch=readiniint(inifile,"CHANNEL","NCH");
-    if (ini->nch<1) {
+    if (ini->nch<1||ini->nch>MAXSAT) {
         SDRPRINTF("error: wrong inifile value NCH=%d\n",ini->nch);
         return -1;
     }
@@ -191,6 +216,11 @@ extern int readinifile(sdrini_t *ini)
             SDRPRINTF("error: wrong inifile value NCH=%d\n",ini->nch);
             return -1;
     }
+    // PRN list entries are assets assigned to SLOTS channel slots
+    ini->nprn=ini->nch;
+    ret=readiniint(inifile,"CHANNEL","SLOTS");
+    if (ret>0&&ret<ini->nprn) ini->nch=ret;
+    readinistr(inifile,"CHANNEL","ASSETCACHE",ini->assetcache);
 
     // Plot settings
     ini->pltacq=readiniint(inifile,"PLOT","ACQ");
@@ -199,6 +229,21 @@ extern int readinifile(sdrini_t *ini)
     // Output setting
     ini->outms   =readiniint(inifile,"OUTPUT","OUTMS");
     ini->sbas    =readiniint(inifile,"OUTPUT","SBAS");
+    readinistr(inifile,"OUTPUT","STATSFILE",ini->statsfile);
+    readinistr(inifile,"OUTPUT","SHMNAME",ini->shmname);
+
+    // Headless mode setting (also -d on the command line)
+    ini->headless=readiniint(inifile,"DAEMON","HEADLESS");
+    readinistr(inifile,"DAEMON","LOG",ini->statuslog);
+    ini->statusms=readiniint(inifile,"DAEMON","STATUSMS");
+
+    // Tracer setting
+    readinistr(inifile,"TRACE","FILE",ini->tracefile);
+    ini->traceon=readiniint(inifile,"TRACE","ON");
+
+    // Metrics endpoint setting
+    ini->metricsport=readiniint(inifile,"METRICS","PORT");
+    readinistr(inifile,"METRICS","ADDR",ini->metricsaddr);
 
     // Spectrum setting
     ini->pltspec=readiniint(inifile,"SPECTRUM","SPEC");
@@ -212,8 +257,19 @@ extern int readinifile(sdrini_t *ini)
     //printf("FONTFILE: %s\n", ini->fontfile);
     ini->ekfFilterOn=readiniint(inifile,"PVT","EKFFILTER");
 
+    // Channel threads setting
+    ini->pool   =readiniint(inifile,"THREADS","POOL");
+    ini->nworker=readiniint(inifile,"THREADS","WORKERS");
+
+    // Thread placement setting
+    readinistr(inifile,"THREADS","CPUS",ini->cpus);
+    readinirole(inifile,"INGEST", &ini->role[ROLE_INGEST]);
+    readinirole(inifile,"CHANNEL",&ini->role[ROLE_CHANNEL]);
+    readinirole(inifile,"SYNC",   &ini->role[ROLE_SYNC]);
+    readinirole(inifile,"GUI",    &ini->role[ROLE_GUI]);
+
     // SDR channel setting
-    for (i=0;i<sdrini.nch;i++) {
+    for (i=0;i<sdrini.nprn;i++) {
         if (sdrini.ctype[i]==CTYPE_L1CA) {
             sdrini.nchL1++;
         }
@@ -228,7 +284,8 @@ extern int readinifile(sdrini_t *ini)
 //----------------------------------------------------------------------------
 extern int chk_initvalue(sdrini_t *ini)
 {
-    int ret;
+    int i,ret,pmin,pmax;
+    cpu_set_t cpus;
 
     // checking frequency input   
     if ((ini->f_sf[0]<=0||ini->f_sf[0]>100e6) ||
@@ -248,6 +305,44 @@ extern int chk_initvalue(sdrini_t *ini)
         }
     }
 
+    // checking tracking quantization   
+    if (ini->trkquant<0||ini->trkquant>2) {
+        SDRPRINTF("error: wrong inifile value QUANT=%d\n",ini->trkquant);
+        return -1;
+    }
+
+    // checking worker pool   
+    if (ini->nworker<0||ini->nworker>MAXWORKER) {
+        SDRPRINTF("error: wrong inifile value WORKERS=%d\n",ini->nworker);
+        return -1;
+    }
+
+    // checking thread placement   
+    for (i=0;i<ROLES;i++) {
+        if (ini->role[i].cpus[0]&&parsecpus(ini->role[i].cpus,&cpus)<=0) {
+            SDRPRINTF("error: wrong inifile value CPUS=%s\n",
+                ini->role[i].cpus);
+            return -1;
+        }
+        if (ini->role[i].policy<0) {
+            SDRPRINTF("error: wrong inifile value SCHED (OTHER/FIFO/RR)\n");
+            return -1;
+        }
+        pmin=sched_get_priority_min(ini->role[i].policy);
+        pmax=sched_get_priority_max(ini->role[i].policy);
+        if (ini->role[i].policy!=SCHED_OTHER&&
+            (ini->role[i].prio<pmin||ini->role[i].prio>pmax)) {
+            SDRPRINTF("error: wrong inifile value PRIO=%d (%d-%d)\n",
+                ini->role[i].prio,pmin,pmax);
+            return -1;
+        }
+        if (ini->role[i].node<-1||ini->role[i].node>=MAXNODE) {
+            SDRPRINTF("error: wrong inifile value NODE=%d\n",
+                ini->role[i].node);
+            return -1;
+        }
+    }
+
     // checking filepath   
     if (ini->fend==FEND_FILE   ||
         ini->fend==FEND_FRTLSDR||ini->fend==FEND_FBLADERF) {
@@ -283,6 +378,11 @@ extern void openhandles(void)
     initmlock(hresetmtx);
     initmlock(hobsvecmtx);
     initmlock(hmsgmtx);
+    initmlock(hslotmtx);
+
+    // events   
+    initevent(hbuffevt);
+    initevent(hepochevt);
 }
 
 // close mutex and event -------------------------------------------------------
@@ -300,6 +400,11 @@ extern void closehandles(void)
     delmlock(hresetmtx);
     delmlock(hobsvecmtx);
     delmlock(hmsgmtx);
+    delmlock(hslotmtx);
+
+    // events   
+    delevent(hbuffevt);
+    delevent(hepochevt);
 }
 
 // initialize acquisition struct -----------------------------------------------
@@ -349,17 +454,46 @@ extern void inittrkprmstruct(sdrtrk_t *trk)
     trk->prm2.fllw =trk->prm2.fllb/0.25;
 }
 
+// tracking accumulator arena -------------------------------------------------
+// one cache line aligned block per channel holding the correlation
+// accumulators contiguously (one array per quantity, each padded to a cache
+// line). allocated once for all channels from the main thread at the first
+// channel initialization and reused when a channel is reset.
+//----------------------------------------------------------------------------
+static double *trkarena=NULL; // accumulator arena (MAXSAT blocks)
+static int trkarrn=0;         // doubles per accumulator array (padded)
+#define TRKARRS       8       // accumulator arrays per channel
+
+static double *trkblock(int chno, int n)
+{
+    int line=CACHELINE/sizeof(double);
+
+    if (!trkarena) {
+        trkarrn=(n+line-1)/line*line;
+        if (posix_memalign((void **)&trkarena,CACHELINE,
+                           sizeof(double)*trkarrn*TRKARRS*MAXSAT)) {
+            trkarena=NULL;
+            return NULL;
+        }
+    }
+    if (chno<1||chno>MAXSAT||n>trkarrn) return NULL;
+    return trkarena+(size_t)trkarrn*TRKARRS*(chno-1);
+}
+
 // initialize tracking struct --------------------------------------------------
 //set value to tracking struct
-//args   : int    sat       I   satellite number
+//args   : int    chno      I   channel number (arena block)
+//         int    sat       I   satellite number
 //         int    ctype     I   code type (CTYPE_L1CA...)
 //         double ctime     I   code period (s)
 //         sdrtrk_t *trk    I/0 tracking struct
 //return : int                  0:okay -1:error
 //----------------------------------------------------------------------------
-extern int inittrkstruct(int sat, int ctype, double ctime, sdrtrk_t *trk)
+extern int inittrkstruct(int chno, int sat, int ctype, double ctime,
+                         sdrtrk_t *trk)
 {
-    int i;
+    int i,n;
+    double *blk;
     int ctimems=(int)(ctime*1000);
 
     // set tracking parameter   
@@ -375,6 +509,8 @@ extern int inittrkstruct(int sat, int ctype, double ctime, sdrtrk_t *trk)
             trk->nl=2*(i+1);   // Late   
         }
     }
+    trk->quant=sdrini.trkquant;
+
     // correlation point for plot   
     (trk->corrx=(double *)calloc(2*trk->corrn+1,sizeof(double)));
     for (i=1;i<=trk->corrn;i++) {
@@ -382,26 +518,29 @@ extern int inittrkstruct(int sat, int ctype, double ctime, sdrtrk_t *trk)
         trk->corrx[2*i  ]= sdrini.trkcorrd*i;
     }
 
-    trk->II     =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->QQ     =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->oldI   =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->oldQ   =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->sumI   =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->sumQ   =(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->oldsumI=(double*)calloc(1+2*trk->corrn,sizeof(double));
-    trk->oldsumQ=(double*)calloc(1+2*trk->corrn,sizeof(double));
+    // correlation accumulators (channel arena block)   
+    n=1+2*trk->corrn;
+    if (!(blk=trkblock(chno,n))) {
+        SDRPRINTF("error: inittrkstruct memory allocation\n");
+        return -1;
+    }
+    memset(blk,0,sizeof(double)*trkarrn*TRKARRS);
+    trk->II     =blk+0*trkarrn;
+    trk->QQ     =blk+1*trkarrn;
+    trk->oldI   =blk+2*trkarrn;
+    trk->oldQ   =blk+3*trkarrn;
+    trk->sumI   =blk+4*trkarrn;
+    trk->sumQ   =blk+5*trkarrn;
+    trk->oldsumI=blk+6*trkarrn;
+    trk->oldsumQ=blk+7*trkarrn;
 
     if (ctype==CTYPE_L1CA)   trk->loop=LOOP_L1CA;
     if (ctype==CTYPE_L1SBAS) trk->loop=LOOP_SBAS;
+    trk->loopdef=trk->loop;
 
     // loop interval (ms)   
     trk->loopms=trk->loop*ctimems;
 
-    if (!trk->II||!trk->QQ||!trk->oldI||!trk->oldQ||!trk->sumI||!trk->sumQ||
-        !trk->oldsumI||!trk->oldsumQ) {
-        SDRPRINTF("error: inittrkstruct memory allocation\n");
-        return -1;
-    }
     return 0;
 }
 
@@ -415,7 +554,7 @@ extern int inittrkstruct(int sat, int ctype, double ctime, sdrtrk_t *trk)
 //----------------------------------------------------------------------------
 extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
 {
-    int i;
+    int i,nw;
     int pre_l1ca[8]= { 1,-1,-1,-1, 1,-1, 1, 1}; // L1CA preamble  
     int pre_sbs[24]= { 1,-1, 1,-1, 1, 1,-1,-1,-1, 1,
                        1,-1,-1, 1,-1, 1,-1,-1, 1, 1,
@@ -466,9 +605,19 @@ extern int initnavstruct(int sys, int ctype, int prn, sdrnav_t *nav)
         for (i=0;i<nav->rate;i++) nav->ocode[i]=1;
     }
 
+    // packed preamble   
+    for (i=0,nav->prepat=0;i<nav->prelen;i++)
+        nav->prepat=(nav->prepat<<1)|(nav->prebits[i]<0);
+
+    // frame bit ring (power of 2 words, one spare word for unaligned reads)   
+    for (nw=1;nw*64<nav->flen+nav->addflen+64;nw*=2) ;
+    nav->fbitsmask=nw-1;
+    nav->nfbits=0;
+
     if (!(nav->bitsync= (int *)calloc(nav->rate,sizeof(int))) ||
-        !(nav->fbits=   (int *)calloc(nav->flen+nav->addflen,sizeof(int))) ||
-        !(nav->fbitsdec=(int *)calloc(nav->flen+nav->addflen,sizeof(int)))) {
+        !(nav->fbits=   (uint64_t *)calloc(nw,sizeof(uint64_t))) ||
+        (ctype==CTYPE_L1SBAS&&
+         !(nav->fbitsdec=(int *)calloc(nav->flen/2,sizeof(int))))) {
             SDRPRINTF("error: initnavstruct memory alocation\n");
             return -1;
     }
@@ -496,8 +645,8 @@ extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
                      int ftype, int f_gain, int f_bias, int f_clock, double f_cf, double f_sf, double f_if,
                      sdrch_t *sdr)
 {
+    const sdrasset_t *asset;
     int i;
-    short *rcode;
 
     sdr->no=chno;
     sdr->sys=sys;
@@ -513,10 +662,11 @@ extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
     sdr->f_if=f_if;
     sdr->ti=1/f_sf;
 
-    // code generation   
-    if (!(sdr->code=gencode(prn,ctype,&sdr->clen,&sdr->crate))) {
-        SDRPRINTF("error: gencode\n"); return -1;
-    }
+    // code (shared PRN code asset, built by assetbuild())   
+    if (!(asset=assetget(prn,ctype,f_sf))) return -1;
+    sdr->code=asset->code;
+    sdr->clen=asset->clen;
+    sdr->crate=asset->crate;
     sdr->ci=sdr->ti*sdr->crate;
     sdr->ctime=sdr->clen/sdr->crate;
     sdr->nsamp=(int)(f_sf*sdr->ctime);
@@ -547,24 +697,16 @@ extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
                             +sdr->foffset;
 
     // tracking struct   
-    if (inittrkstruct(sdr->sat,ctype,sdr->ctime,&sdr->trk)<0) return -1;
+    if (inittrkstruct(chno,sdr->sat,ctype,sdr->ctime,&sdr->trk)<0) return -1;
+    sdr->trk.corrfunc=getcorrfunc(dtype,sdr->trk.corrn,sdrini.trkcorrd);
+    sdr->trk.corrfuncepl=getcorrfunc(dtype,1,sdrini.trkcorrp);
 
     // navigation struct   
     if (initnavstruct(sys,ctype,prn,&sdr->nav)<0) {
         return -1;
     }
-    // memory allocation   
-    if (!(rcode=(short *)sdrmalloc(sizeof(short)*sdr->acq.nfft)) ||
-        !(sdr->xcode=cpxmalloc(sdr->acq.nfft))) {
-            SDRPRINTF("error: initsdrch memory alocation\n"); return -1;
-    }
-    // other code generation   
-    for (i=0;i<sdr->acq.nfft;i++) rcode[i]=0; // zero padding   
-    rescode(sdr->code,sdr->clen,0,0,sdr->ci,sdr->nsamp,rcode); // resampling   
-    cpxcpx(rcode,NULL,1.0,sdr->acq.nfft,sdr->xcode); // FFT for acquisition   
-    cpxfft(NULL,sdr->xcode,sdr->acq.nfft);
-
-    sdrfree(rcode);
+    // resampled code in frequency domain for acquisition (shared asset)   
+    sdr->xcode=asset->xcode;
     return 0;
 }
 
@@ -575,20 +717,12 @@ extern int initsdrch(int chno, int sys, int prn, int ctype, int dtype,
 //----------------------------------------------------------------------------
 extern void freesdrch(sdrch_t *sdr)
 {
-    free(sdr->code);
-    cpxfree(sdr->xcode);
+    // code and xcode belong to the PRN code asset store (assetfree())
     free(sdr->nav.fbits);
     free(sdr->nav.fbitsdec);
     free(sdr->nav.bitsync);
-    free(sdr->trk.II);
-    free(sdr->trk.QQ);
-    free(sdr->trk.oldI);
-    free(sdr->trk.oldQ);
-    free(sdr->trk.sumI);
-    free(sdr->trk.sumQ);
-    free(sdr->trk.oldsumI);
-    free(sdr->trk.oldsumQ);
     free(sdr->trk.corrp);
+    free(sdr->trk.corrx);
     free(sdr->acq.freq);
 
     if (sdr->nav.fec!=NULL)
@@ -597,3 +731,15 @@ extern void freesdrch(sdrch_t *sdr)
     if (sdr->nav.ocode!=NULL)
         free(sdr->nav.ocode);
 }
+
+// free tracking accumulator arena ---------------------------------------------
+//free the accumulator blocks of all channels (after freesdrch())
+//args   : none
+//return : none
+//----------------------------------------------------------------------------
+extern void freetrkarena(void)
+{
+    free(trkarena);
+    trkarena=NULL;
+    trkarrn=0;
+}
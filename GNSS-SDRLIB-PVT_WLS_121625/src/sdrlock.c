@@ -0,0 +1,260 @@
+//-----------------------------------------------------------------------------
+// sdrlock.c : mutex contention profiler (build with -DLOCKPROF)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+#include <errno.h>
+
+#ifdef LOCKPROF
+#define MAXLOCKPROF   128              // max profiled mutexes (hash size)
+#define MAXLOCKSITE   256              // max call sites
+#define LOCKREPORTS   30               // status window report interval (s)
+
+// mutex statistics (updated by the holder of the mutex)
+typedef struct {
+        const void *mtx; // mutex (NULL: free entry)
+        const char *name; // mutex name (mlock() argument)
+        uint64_t nacq;   // acquisitions
+        uint64_t ncont;  // contended acquisitions
+        uint64_t waitns; // total wait time (ns)
+        uint64_t maxwaitns; // max wait time (ns)
+        uint64_t maxholdns; // max hold time (ns)
+        uint64_t t0;     // lock time of the holder (ns)
+        int site;        // call site of the holder
+} lockprof_t;
+
+// call site statistics (updated by the holder of the site's mutex)
+typedef struct {
+        const char *file; // source file
+        int line;        // source line
+        int lock;        // mutex entry (first mutex seen at the site)
+        uint64_t nacq;   // acquisitions
+        uint64_t ncont;  // contended acquisitions
+        uint64_t waitns; // total wait time (ns)
+        uint64_t maxholdns; // max hold time (ns)
+} locksite_t;
+
+static lockprof_t lockprof[MAXLOCKPROF]; // mutexes (hashed by address)
+static locksite_t locksite[MAXLOCKSITE]; // call sites
+static int nlocksite=0;                 // number of call sites
+static pthread_mutex_t hprofmtx=PTHREAD_MUTEX_INITIALIZER; // table insertion
+
+// time (ns) -------------------------------------------------------------------
+static uint64_t nowns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+// mutex entry -----------------------------------------------------------------
+// find (or add) the entry of a mutex, lock free once the entry exists
+static lockprof_t *getlock(const void *mtx, const char *name)
+{
+    unsigned int h=(unsigned int)(((uintptr_t)mtx>>4)%MAXLOCKPROF),i;
+    const void *p;
+
+    for (i=0;i<MAXLOCKPROF;i++,h=(h+1)%MAXLOCKPROF) {
+        p=__atomic_load_n(&lockprof[h].mtx,__ATOMIC_ACQUIRE);
+        if (p==mtx) return &lockprof[h];
+        if (p) continue;
+
+        pthread_mutex_lock(&hprofmtx);
+        if (!lockprof[h].mtx) {
+            lockprof[h].name=name?name:"?";
+            lockprof[h].site=-1;
+            __atomic_store_n(&lockprof[h].mtx,mtx,__ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&hprofmtx);
+        if (lockprof[h].mtx==mtx) return &lockprof[h];
+    }
+    return NULL; // table full
+}
+
+// call site entry -------------------------------------------------------------
+static int getsite(int *site, const char *file, int line, int lock)
+{
+    int i=__atomic_load_n(site,__ATOMIC_ACQUIRE);
+
+    if (i>=0) return i;
+
+    pthread_mutex_lock(&hprofmtx);
+    if ((i=*site)<0&&nlocksite<MAXLOCKSITE) {
+        i=nlocksite;
+        locksite[i].file=file;
+        locksite[i].line=line;
+        locksite[i].lock=lock;
+        __atomic_store_n(&nlocksite,i+1,__ATOMIC_RELEASE);
+        __atomic_store_n(site,i,__ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&hprofmtx);
+    return i;
+}
+
+// hold time -------------------------------------------------------------------
+static void endhold(lockprof_t *p)
+{
+    uint64_t hold;
+
+    if (!p||!p->t0) return;
+    hold=nowns()-p->t0;
+    if (hold>p->maxholdns) p->maxholdns=hold;
+    if (p->site>=0&&hold>locksite[p->site].maxholdns) {
+        locksite[p->site].maxholdns=hold;
+    }
+    p->t0=0;
+}
+
+// lock mutex (mlock) ----------------------------------------------------------
+// lock a mutex and record the acquisition, contention and wait time for the
+// mutex and the call site
+// args   : pthread_mutex_t *mtx I mutex
+//          char   *name     I   mutex name (mlock() argument)
+//          char   *file     I   source file of the call site
+//          int    line      I   source line of the call site
+//          int    *site     I/O call site index (static at the site, -1: new)
+// return : int                  pthread_mutex_lock() status
+//-----------------------------------------------------------------------------
+extern int lockprofacq(pthread_mutex_t *mtx, const char *name,
+                       const char *file, int line, int *site)
+{
+    lockprof_t *p;
+    locksite_t *s;
+    uint64_t t0=nowns(),t1,wait;
+    int ret,cont=0,i;
+
+    if ((ret=pthread_mutex_trylock(mtx))==EBUSY) {
+        cont=1;
+        ret=pthread_mutex_lock(mtx);
+    }
+    if (ret) return ret;
+    t1=nowns();
+    wait=t1-t0;
+
+    if (!(p=getlock(mtx,name))) return 0;
+    i=getsite(site,file,line,(int)(p-lockprof));
+
+    p->nacq++;
+    p->ncont+=cont;
+    p->waitns+=wait;
+    if (wait>p->maxwaitns) p->maxwaitns=wait;
+    if (i>=0) {
+        s=&locksite[i];
+        s->nacq++;
+        s->ncont+=cont;
+        s->waitns+=wait;
+    }
+    p->site=i;
+    p->t0=t1;
+    return 0;
+}
+
+// unlock mutex (unmlock) ------------------------------------------------------
+extern int lockprofrel(pthread_mutex_t *mtx)
+{
+    endhold(getlock(mtx,NULL));
+    return pthread_mutex_unlock(mtx);
+}
+
+// wait event (waitevent, timedwaitevent) --------------------------------------
+// the mutex is released while waiting: the hold ends before the wait and
+// starts again after it (same call site, not counted as acquisition)
+// args   : pthread_cond_t *cond I condition variable
+//          pthread_mutex_t *mtx I mutex (locked)
+//          struct timespec *t I absolute timeout (NULL: none)
+// return : int                  pthread_cond_(timed)wait() status
+//-----------------------------------------------------------------------------
+extern int lockprofwait(pthread_cond_t *cond, pthread_mutex_t *mtx,
+                        const struct timespec *t)
+{
+    lockprof_t *p=getlock(mtx,NULL);
+    int ret;
+
+    endhold(p);
+    ret=t?pthread_cond_timedwait(cond,mtx,t):pthread_cond_wait(cond,mtx);
+    if (p) p->t0=nowns();
+    return ret;
+}
+
+// mutexes by total wait time --------------------------------------------------
+static int sortlocks(lockprof_t **list)
+{
+    lockprof_t *p;
+    int i,j,n=0;
+
+    for (i=0;i<MAXLOCKPROF;i++) {
+        if (!__atomic_load_n(&lockprof[i].mtx,__ATOMIC_ACQUIRE)||
+            !lockprof[i].nacq) continue;
+        p=&lockprof[i];
+        for (j=n++;j>0&&list[j-1]->waitns<p->waitns;j--) list[j]=list[j-1];
+        list[j]=p;
+    }
+    return n;
+}
+#endif
+
+// lock profile report ---------------------------------------------------------
+// post the mutexes with the longest total wait to the program status window
+// every LOCKREPORTS (called from the supervisor, no-op without LOCKPROF)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void lockprofreport(void)
+{
+#ifdef LOCKPROF
+    static unsigned long tick0=0;
+    unsigned long tick=tickgetus();
+    lockprof_t *list[MAXLOCKPROF],*p;
+    char msg[MSG_LENGTH];
+    int i,n;
+
+    if (tick0&&tick-tick0<LOCKREPORTS*1000000UL) return;
+    tick0=tick;
+
+    n=sortlocks(list);
+    for (i=0;i<n&&i<3;i++) {
+        p=list[i];
+        snprintf(msg,sizeof(msg),"%.3f  lock %-12.12s acq %llu cont %.1f%% "
+            "wait %.1f ms (max %.2f) hold max %.2f ms",sdrstat.elapsedTime,
+            p->name,(unsigned long long)p->nacq,100.0*p->ncont/p->nacq,
+            p->waitns*1E-6,p->maxwaitns*1E-6,p->maxholdns*1E-6);
+        add_message(msg);
+    }
+#endif
+}
+
+// lock profile dump -----------------------------------------------------------
+// print the statistics of all mutexes and their call sites (at exit, no-op
+// without LOCKPROF)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void lockprofdump(void)
+{
+#ifdef LOCKPROF
+    lockprof_t *list[MAXLOCKPROF],*p;
+    locksite_t *s;
+    int i,j,n=sortlocks(list),nsite=__atomic_load_n(&nlocksite,__ATOMIC_ACQUIRE);
+
+    SDRPRINTF("lock profile: %d mutexes, %d call sites\n",n,nsite);
+    SDRPRINTF("  %-22s %10s %10s %6s %10s %9s %9s\n","mutex / call site",
+        "acq","contended","%","wait ms","maxwait","maxhold");
+    for (i=0;i<n;i++) {
+        p=list[i];
+        SDRPRINTF("  %-22.22s %10llu %10llu %6.2f %10.2f %9.3f %9.3f\n",p->name,
+            (unsigned long long)p->nacq,(unsigned long long)p->ncont,
+            100.0*p->ncont/p->nacq,p->waitns*1E-6,p->maxwaitns*1E-6,
+            p->maxholdns*1E-6);
+
+        for (j=0;j<nsite;j++) {
+            s=&locksite[j];
+            if (&lockprof[s->lock]!=p||!s->nacq) continue;
+            SDRPRINTF("    %14.14s:%-5d %10llu %10llu %6.2f %10.2f %9s %9.3f\n",
+                strrchr(s->file,'/')?strrchr(s->file,'/')+1:s->file,s->line,
+                (unsigned long long)s->nacq,(unsigned long long)s->ncont,
+                100.0*s->ncont/s->nacq,s->waitns*1E-6,"",s->maxholdns*1E-6);
+        }
+    }
+#endif
+}
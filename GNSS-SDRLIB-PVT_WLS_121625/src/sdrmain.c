@@ -12,6 +12,7 @@ thread_t hsyncthread;
 thread_t hkeythread;
 thread_t hdatathread;
 thread_t hguithread;
+thread_t hsupthread;
 
 mlock_t hbuffmtx;
 mlock_t hreadmtx;
@@ -20,6 +21,10 @@ mlock_t hobsmtx;
 mlock_t hresetmtx;
 mlock_t hobsvecmtx;
 mlock_t hmsgmtx;
+mlock_t hslotmtx;
+
+event_t hbuffevt;
+event_t hepochevt;
 
 // SDR structs
 sdrini_t sdrini={0};
@@ -35,12 +40,36 @@ sdrgui_t sdrgui={0};
 //-----------------------------------------------------------------------------
 extern void *keythread(void * arg)
 {
+  int diagtaps=0;
+
+  schedrole(ROLE_GUI);
+  probethread("sdr-key");
+
   do {
     switch(getchar()) {
       case 'q':
       case 'Q':
         sdrstat.stopflag=1;
         break;
+      case 'c':
+      case 'C':
+        // Toggle full correlator tap set on all channels (diagnostics)
+        if ((diagtaps=!diagtaps)) subscribetaps(NULL);
+        else unsubscribetaps(NULL);
+        add_message(diagtaps?"Full correlator taps on":
+                             "Full correlator taps off (E/P/L)");
+        break;
+      case 't':
+      case 'T':
+        // Switch the pipeline tracer ([TRACE] FILE)
+        switch (tracetoggle()) {
+          case 1:  add_message("Trace on"); break;
+          case 0:  add_message("Trace off"); break;
+          case -2: add_messagef("Trace: cannot open %s",sdrini.tracefile);
+                   break;
+          default: add_message("Trace: no [TRACE] FILE"); break;
+        }
+        break;
       default:
         SDRPRINTF("press 'q' to exit...\n");
         break;
@@ -52,7 +81,7 @@ extern void *keythread(void * arg)
 
 // main function --------------------------------------------------------------
 // main entry point in CLI application
-// args   : none
+// args   : -d      headless mode (same as [DAEMON] HEADLESS=1)
 // return : none
 //-----------------------------------------------------------------------------
 int main(int argc, char **argv)
@@ -64,24 +93,15 @@ int main(int argc, char **argv)
   if (readinifile(&sdrini)<0) {
     return -1;
   }
-
-  // Declare CPU affinity variables
-  int num_cpus;
-  cpu_set_t cpu_set;
-
-  // Find the number of available processor CPUs with sysconf call.
-  num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-
-  // We will leave the last four CPUs for OS tasks, then enable the rest for
-  // real-time use by main. Select CPUs to use with CPU_SET.
-  for (int n=0;n<(num_cpus-4);n++) {
-    CPU_SET(n, &cpu_set);
+  for (int i=1;i<argc;i++) {
+    if (!strcmp(argv[i],"-d")) sdrini.headless=1;
   }
 
-  // Schedule the cores for use by main using sched_setaffinity
-  if (sched_setaffinity(getpid(), sizeof(cpu_set_t), &cpu_set) == -1) {
-    perror("error: sched_setaffinity\n");
-  }
+  // Headless: shutdown signals go to the main thread only (before any thread)
+  if (sdrini.headless) daemonsignals();
+
+  // Process cpus ([THREADS] CPUS), threads are placed by role
+  schedprocess();
 
   // Start SDR and threads
   startsdr();
@@ -89,159 +109,14 @@ int main(int argc, char **argv)
   return 0;
 }
 
-// sdr start ------------------------------------------------------------------
-// start sdr function
-// args   : void   *arg      I   not used
-// return : none
-// note : This is called as a function in CLI application
+// GUI loop -------------------------------------------------------------------
+// ncurses status windows, redrawn every 100 ms on the main thread until stop
 //-----------------------------------------------------------------------------
-extern void startsdr(void)
+static void guirun(void)
 {
-
-  int i;
-  SDRPRINTF("GNSS-SDRLIB start!\n");
-
-  // The following can be enabled if using the real-time Ubuntu kernel.
-  // Establish attr and param for real time threads.
-  /*
-  struct sched_param param1;
-  struct sched_param param2;
-  pthread_attr_t attr1;
-  pthread_attr_t attr2;
-  */
-
-  // Thread return state
-  int ret = 0;
-
-  // The following can be enabled if using the real-time Ubuntu kernel.
-  /*
-  // Declare thread attribute attr1 and attr2
-  ret = pthread_attr_init(&attr1);
-  if (ret) {
-    printf("Init for thread attr1 failed: %s\n", strerror(ret));
-  }
-  ret = pthread_attr_init(&attr2);
-  if (ret) {
-    printf("Init for thread attr2 failed: %s\n", strerror(ret));
-  }
-
-  // Set stack size
-  ret = pthread_attr_setstacksize(&attr1, PTHREAD_STACK_MIN);
-  if (ret) {
-    printf("Stack size for thread attr1 failed: %s\n", strerror(ret));
-  }
-  ret = pthread_attr_setstacksize(&attr2, PTHREAD_STACK_MIN);
-  if (ret) {
-    printf("Stack size for thread attr2 failed: %s\n", strerror(ret));
-  }
-
-  // Set scheduler policy and priority
-  ret = pthread_attr_setschedpolicy(&attr1, SCHED_FIFO);
-  if (ret) {
-    printf("Policy for thread attr1 failed: %s\n", strerror(ret));
-  }
-  ret = pthread_attr_setschedpolicy(&attr2, SCHED_OTHER);
-  if (ret) {
-    printf("Policy for thread attr2 failed: %s\n", strerror(ret));
-  }
-
-  // Set thread priority in attr and param
-  param1.sched_priority = 80;
-  ret = pthread_attr_setschedparam(&attr1, &param1);
-  if (ret) {
-    printf("Priority for thread attr1 failed: %s\n", strerror(ret));
-  }
-  param2.sched_priority = 0;
-  ret = pthread_attr_setschedparam(&attr2, &param2);
-  if (ret) {
-    printf("Priority for thread attr2 failed: %s\n", strerror(ret));
-  }
-
-  // Direct attr to use the scheduling parameters we set
-  ret = pthread_attr_setinheritsched(&attr1, PTHREAD_EXPLICIT_SCHED);
-  if (ret) {
-    printf("Inherit for thread attr1 failed: %s\n", strerror(ret));
-  }
-  ret = pthread_attr_setinheritsched(&attr2, PTHREAD_EXPLICIT_SCHED);
-  if (ret) {
-    printf("Inherit for thread attr2 failed: %s\n", strerror(ret));
-  }
-  */
-
-  // Check initial value
-  if (chk_initvalue(&sdrini)<0) {
-    SDRPRINTF("error: chk_initvalue\n");
-    quitsdr(&sdrini,1);
-    return;
-  }
-
-  // Receiver initialization
-  if (rcvinit(&sdrini)<0) {
-    SDRPRINTF("error: rcvinit\n");
-    quitsdr(&sdrini,1);
-    return;
-  }
-
-  // Initialize sdr channel struct
-  for (i=0;i<sdrini.nch;i++) {
-    if (initsdrch(i+1,sdrini.sys[i],sdrini.prn[i],sdrini.ctype[i],
-      sdrini.dtype[sdrini.ftype[i]-1],sdrini.ftype[i],
-      sdrini.f_gain[sdrini.ftype[i]-1],sdrini.f_bias[sdrini.ftype[i]-1],
-      sdrini.f_clock[sdrini.ftype[i]-1],sdrini.f_cf[sdrini.ftype[i]-1],
-      sdrini.f_sf[sdrini.ftype[i]-1],sdrini.f_if[sdrini.ftype[i]-1],
-      &sdrch[i])<0) {
-
-      SDRPRINTF("error: initsdrch\n");
-      quitsdr(&sdrini,2);
-      return;
-    }
-  }
-
-  // Mutexes and events
-  openhandles();
-
-  // Create threads ---------------------------------------------------------
-  // Keyboard thread
-  //ret = pthread_create(&hkeythread,&attr2,keythread,NULL);
-  ret = pthread_create(&hkeythread,NULL,keythread,NULL);
-  if (ret) {
-    printf(BRED "Create for keyboard thread failed: %s\n" reset,
-         strerror(ret));
-  }
-
-  // Sync thread
-  //ret = pthread_create(&hsyncthread,&attr1,syncthread,NULL);
-  ret = pthread_create(&hsyncthread,NULL,syncthread,NULL);
-  if (ret) {
-    printf(BRED "Create for sync thread failed: %s\n" reset,
-           strerror(ret));
-  }
-
-  // SDR channel threads
-  for (i=0;i<sdrini.nch;i++) {
-    // GPS/QZS/GLO/GAL/CMP L1
-    if (sdrch[i].ctype==CTYPE_L1CA  || sdrch[i].ctype==CTYPE_L1SBAS){
-      //ret=pthread_create(&sdrch[i].hsdr,&attr1,sdrthread,&sdrch[i]);
-      ret=pthread_create(&sdrch[i].hsdr,NULL,sdrthread,&sdrch[i]);
-      if (ret) {
-        printf(BRED "Create for sdr thread failed: %s\n" reset,
-               strerror(ret));
-      } // if
-    } // if
-  } // for (sdrch threads)
-
-  //printf("Calling data grabber (rcvgrabdata).\n");
-  // Data grabber for continuously filling the memory FIFO buffer. RTLSDR
-  // requires the call to be in a while loop, so a thread is used. HydraSDR,
-  // BladeRF and HackRF start their own thread. Threads are also use for reading
-  // data from files.
-  //
-  // Receiver streaming start
-  if (rcvgrabstart(&sdrini)<0) {
-    SDRPRINTF("error: rcvgrabstart\n");
-    quitsdr(&sdrini,1);
-    return;
-  }
+  // GUI loop runs on the main thread
+  schedrole(ROLE_GUI);
+  probethread("sdr-gui");
 
   // Initialize ncurses
   initscr();
@@ -307,7 +182,8 @@ extern void startsdr(void)
     long ns = current_time.tv_nsec - start_time.tv_nsec;
     sdrstat.elapsedTime = ((seconds * 1000) + (ns / 1e6) ) / 1000.0;
 
-    // Update both status windows
+    // Format the logged events into messages, update both status windows
+    evdrain();
     updateNavStatusWin(win1, counter);
     updateProgramStatusWin(win2, hgt2);
 
@@ -324,22 +200,172 @@ extern void startsdr(void)
 
   } // end main while
 
-  // Cleanup threads and messages
-  for (int i = 0; i < sdrgui.message_count; i++) {
-    free(sdrgui.messages[i]);
-  }
-
   // Cleanup ncurses memory
   delwin(win1);
   delwin(win2);
   endwin();
+}
+
+// sdr start ------------------------------------------------------------------
+// start sdr function
+// args   : void   *arg      I   not used
+// return : none
+// note : This is called as a function in CLI application
+//-----------------------------------------------------------------------------
+extern void startsdr(void)
+{
+
+  int i;
+  SDRPRINTF("GNSS-SDRLIB start!\n");
+
+  // Thread return state
+  int ret = 0;
+
+  // Check initial value
+  if (chk_initvalue(&sdrini)<0) {
+    SDRPRINTF("error: chk_initvalue\n");
+    quitsdr(&sdrini,1);
+    return;
+  }
+
+  // Receiver initialization
+  if (rcvinit(&sdrini)<0) {
+    SDRPRINTF("error: rcvinit\n");
+    quitsdr(&sdrini,1);
+    return;
+  }
+
+  // PRN code assets of the PRN list (built in parallel or from the cache)
+  if (assetbuild()<0) {
+    SDRPRINTF("error: assetbuild\n");
+    quitsdr(&sdrini,2);
+    return;
+  }
+
+  // Initialize sdr channel slots (first PRNs of the PRN list)
+  if (slotstart()<0) {
+    SDRPRINTF("error: initsdrch\n");
+    quitsdr(&sdrini,2);
+    return;
+  }
+
+  // Ring buffer on the NUMA node of the ingest thread
+  schedbuff(sdrstat.buff,sdrstat.buffsize);
+
+  // Mutexes and events
+  openhandles();
+
+  // Tracking plot consumes all correlation points
+  if (sdrini.plttrk) subscribetaps(NULL);
+
+  // Pipeline tracer ([TRACE] FILE)
+  tracestart();
+
+  // Metrics endpoint ([METRICS] PORT)
+  metricsstart();
+
+  // Shared memory status segment ([OUTPUT] SHMNAME)
+  shmstart();
+
+  // Create threads ---------------------------------------------------------
+  // Keyboard thread (not in headless mode)
+  //ret = pthread_create(&hkeythread,&attr2,keythread,NULL);
+  ret = sdrini.headless?0:pthread_create(&hkeythread,NULL,keythread,NULL);
+  if (ret) {
+    printf(BRED "Create for keyboard thread failed: %s\n" reset,
+         strerror(ret));
+  }
+
+  // Sync thread
+  //ret = pthread_create(&hsyncthread,&attr1,syncthread,NULL);
+  ret = pthread_create(&hsyncthread,NULL,syncthread,NULL);
+  if (ret) {
+    printf(BRED "Create for sync thread failed: %s\n" reset,
+           strerror(ret));
+  }
+
+  // Supervisor thread (real-time load monitor and load shedding)
+  ret = pthread_create(&hsupthread,NULL,supthread,NULL);
+  if (ret) {
+    printf(BRED "Create for supervisor thread failed: %s\n" reset,
+           strerror(ret));
+  }
+
+  // SDR channels: worker pool, or one thread per channel
+  if (sdrini.pool) {
+    if (poolstart()<0) {
+      SDRPRINTF("error: poolstart\n");
+    }
+  } else {
+    for (i=0;i<sdrini.nch;i++) {
+      // GPS/QZS/GLO/GAL/CMP L1
+      if (sdrch[i].ctype==CTYPE_L1CA  || sdrch[i].ctype==CTYPE_L1SBAS){
+        //ret=pthread_create(&sdrch[i].hsdr,&attr1,sdrthread,&sdrch[i]);
+        ret=pthread_create(&sdrch[i].hsdr,NULL,sdrthread,&sdrch[i]);
+        if (ret) {
+          printf(BRED "Create for sdr thread failed: %s\n" reset,
+                 strerror(ret));
+        } // if
+      } // if
+    } // for (sdrch threads)
+  }
+
+  //printf("Calling data grabber (rcvgrabdata).\n");
+  // Data grabber for continuously filling the memory FIFO buffer. RTLSDR
+  // requires the call to be in a while loop, so a thread is used. HydraSDR,
+  // BladeRF and HackRF start their own thread. Threads are also use for reading
+  // data from files.
+  //
+  // Receiver streaming start
+  if (rcvgrabstart(&sdrini)<0) {
+    SDRPRINTF("error: rcvgrabstart\n");
+    quitsdr(&sdrini,1);
+    return;
+  }
+
+  // Headless: the main thread waits for signals, else the GUI loop
+  if (sdrini.headless) daemonrun();
+  else guirun();
 
   // Wait (pthreads join) threads
   waitthread(hsyncthread);
-  for (i=0;i<sdrini.nch;i++) {
-    waitthread(sdrch[i].hsdr);
+  if (sdrini.pool) {
+    poolwait();
+  } else {
+    for (i=0;i<sdrini.nch;i++) {
+      // GPS/QZS/GLO/GAL/CMP L1
+      if (sdrch[i].ctype==CTYPE_L1CA  || sdrch[i].ctype==CTYPE_L1SBAS){
+        waitthread(sdrch[i].hsdr);
+      }
+    }
   }
   waitthread(hdatathread);
+  waitthread(hsupthread);
+
+  // Load shedding counters (for sizing the hardware)
+  supsummary();
+
+  // Stage latencies and thread cpu times
+  probesummary();
+
+  // Last trace events
+  tracestop();
+
+  // Metrics endpoint and status segment
+  metricsstop();
+  shmstop();
+
+  // Mutex contention profile (LOCKPROF build)
+  lockprofdump();
+
+  // Program messages (no thread posts messages after the joins)
+  mlock(hmsgmtx);
+  for (i=0;i<sdrgui.message_count;i++) {
+    free(sdrgui.messages[i]);
+    sdrgui.messages[i]=NULL;
+  }
+  sdrgui.message_count=0;
+  unmlock(hmsgmtx);
 
   // SDR termination
   quitsdr(&sdrini,0);
@@ -365,6 +391,8 @@ extern void quitsdr(sdrini_t *ini, int stop)
 
     // Free memory
     for (i=0;i<ini->nch;i++) freesdrch(&sdrch[i]);
+    freetrkarena();
+    assetfree();
     if (stop==3) return;
 
     // Mutexes and events
@@ -377,22 +405,18 @@ extern void quitsdr(sdrini_t *ini, int stop)
 // args   : void   *arg      I   sdr channel struct
 // return : none
 // note : This thread handles the acquisition and tracking of one of the signals.
-//        The thread is created at startsdr function.
+//        The thread is created at startsdr function when the worker pool is
+//        not used ([THREADS] POOL=0).
 //-----------------------------------------------------------------------------
 extern void *sdrthread(void *arg)
 {
   sdrch_t *sdr=(sdrch_t*)arg;
-  uint64_t buffloc=0,bufflocnow=0,cnt=0,loopcnt=0;
-  double *acqpower=NULL;
-  double snr, el;
-  int ret = 0;
-  char bufferSDR[MSG_LENGTH];
+  int delay;
+  char name[16];
 
-  // Establish timer parameters
-  time_t current_time;//start_time_acq,start_time_nav,start_time_snr,
-  time_t start_acq_timer; // Starts when flagacq equals 1
-  start_acq_timer = time(NULL); // declare it here, but really assigned by acq
-  double elapsed_acq_time = 0;
+  schedrole(ROLE_CHANNEL);
+  snprintf(name, sizeof(name), "sdr-ch%02d", sdr->no);
+  probethread(name);
 
   // Slightly delay the start of each thread independently
   sleepms(sdr->no*500);
@@ -401,165 +425,180 @@ extern void *sdrthread(void *arg)
   // While loop for sdrch thread
   //-------------------------------------------------------------------------
   while (!sdrstat.stopflag) {
+    delay = sdrchstep(sdr);
+    if (delay==STEPWAITDATA) rcvwaitbuff(sdr->needcnt,DATAWAITMS);
+    else if (delay>0) sleepms(delay);
+  } // end while
 
-    // SDR Channel Reset Checks -------------------------------------------
-    // Calculate elapsed time since flagacq was set.
-    current_time = time(NULL);
-    if (sdr->flagacq) {
-      elapsed_acq_time = current_time - start_acq_timer;
-    }
+  // Thread finished
+  sdrchfinish(sdr);
 
-    // Every 30s check SNR to make sure it is not too low
-    if (elapsed_acq_time>60) {
-      mlock(hobsmtx);
-      snr = sdr->trk.S[0];
-      unmlock(hobsmtx);
+  return THRETVAL;
+}
 
-      // If SNR is low, set resetflag for this channel
-      if (snr<SNR_RESET_THRES) {
+// SDR channel step -----------------------------------------------------------
+// one step of the sdr channel state machine: reset checks, acquisition or
+// tracking of the available code periods. All channel state lives in sdrch_t
+// so that a step can run on any thread (channel thread or pool worker).
+// args   : sdrch_t *sdr     I/O sdr channel struct
+// return : int                  delay before the next step (ms), 0: runnable,
+//                               STEPWAITDATA: wait for buffer count needcnt
+//-----------------------------------------------------------------------------
+static int chstep(sdrch_t *sdr)
+{
+  double el;
+  uint64_t t0;
+  int ret = 0;
+  time_t current_time;
 
-        snprintf(bufferSDR, sizeof(bufferSDR),
-          "%.3f  G%02d resetting with SNR of %.1f and flagacq of %d\n",
-           sdrstat.elapsedTime, sdr->prn, snr, sdr->flagacq);
-        add_message(bufferSDR);
+  // Load shedding ------------------------------------------------------
+  // Channel dropped by the supervisor: release it and idle until restored
+  if (sdrstat.shedch[sdr->no-1]) {
+    if (sdr->flagacq) {
+      ret = resetStructs(sdr, slotrelease(sdr, SLOT_SHED));
+      if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
+    }
+    return SUPINTMS;
+  }
 
-        // Reset struct terms
-        int i = sdr->prn - 1;
-        ret = resetStructs(&sdrch[i]);
-        elapsed_acq_time = 0; // reset elapsed acq time
-        if (ret==-1) { printf("resetStructs: error\n"); }
+  // SDR Channel Reset Checks -------------------------------------------
+  // Calculate elapsed time since flagacq was set.
+  current_time = time(NULL);
+  if (sdr->flagacq) {
+    sdr->elapsed_acq_time = current_time - sdr->start_acq_timer;
+  }
 
-        // Continue to next iteration of while loop
-        continue;
+  // Loss of lock (lock detectors, see lockdetect()). A lost signal or a
+  // ring buffer overrun (see trackbacklog()) is reacquired at once on the
+  // same PRN, a channel which never locked after acquisition (false
+  // acquisition) hands the slot on.
+  if (sdr->flagacq && sdr->trk.flaglost) {
+    if (sdr->trk.flaglost!=3) {
+      evlog(sdr->trk.flaglost==1?EV_LOSTLOCK:EV_NOLOCK, sdr->prn,
+        sdr->trk.cn0, sdr->trk.pli, 0);
+    }
+    ret = resetStructs(sdr, sdr->trk.flaglost!=2?sdr->asset:
+                            slotrelease(sdr, SLOT_ACQFAIL));
+    if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
+    return 0;
+  }
 
-      } // end if
-    } // end if
+  // Check to see if tracking and nav decode is successful.
+  // Reset channel if not. Make sure GPS week is near current week (and
+  // thus non-zero).
+  // NOTE: May want to eventually solve for current GPS week rather than
+  // using the default GPS_WEEK value.
+  if (sdr->elapsed_acq_time>60) {
 
-    // Check to see if tracking and nav decode is successful.
-    // Reset channel if not. Make sure GPS week is near current week (and
-    // thus non-zero).
-    // NOTE: May want to eventually solve for current GPS week rather than
-    // using the default GPS_WEEK value.
-    if (elapsed_acq_time>60) {
-
-      // Check several nav flags
-      if (!sdr->nav.flagdec ||
-          !sdr->nav.flagsync ||
-          (sdr->nav.sdreph.week_gpst<GPS_WEEK) ) {
-
-        snprintf(bufferSDR, sizeof(bufferSDR),
-          "%.3f  G%02d resetting, flagdec:%d, flagsync:%d, Week:%d\n",
-               sdrstat.elapsedTime, sdr->prn, sdr->nav.flagdec, sdr->nav.flagsync,
-               sdr->nav.sdreph.week_gpst);
-        add_message(bufferSDR);
-
-        // Reset struct terms
-        int i = sdr->prn - 1;
-        ret = resetStructs(&sdrch[i]);
-        elapsed_acq_time = 0; // reset elapsed acq time
-        if (ret==-1) { printf("resetStructs: error\n"); }
-
-        // Break out of while loop
-        continue;
-      }  // end if
-    } // end if
+    // Check several nav flags
+    if (!sdr->nav.flagdec ||
+        !sdr->nav.flagsync ||
+        (sdr->nav.sdreph.week_gpst<GPS_WEEK) ) {
 
-    // Check SV elevation
-    if (elapsed_acq_time>60) {
-      // Pull values
-      mlock(hobsmtx);
-      int i = sdr->prn - 1;
-      el = sdrstat.obs_v[i*11+10];
-      unmlock(hobsmtx);
-
-      // Check several nav flags
-      if (el < SV_EL_RESET_MASK) {
-
-        snprintf(bufferSDR, sizeof(bufferSDR),
-          "%.3f  G%02d resetting, SV el: %.1f\n",
-          sdrstat.elapsedTime, i+1, el);
-        add_message(bufferSDR);
-
-        // Reset struct terms
-        int i = sdr->prn - 1;
-        ret = resetStructs(&sdrch[i]);
-        elapsed_acq_time = 0; // reset elapsed acq time
-        if (ret==-1) { printf("resetStructs: error\n"); }
-
-        // Break out of while loop
-        continue;
-      }  // end if
-    } // end if
+      evlog(EV_RESETNAV, sdr->prn, sdr->nav.flagdec, sdr->nav.flagsync,
+            sdr->nav.sdreph.week_gpst);
 
-    // Check if mismatch between flagacq setting and obs use for pvt
-    //checkObsDelay(sdr->prn);
+      // Release the PRN and reset the slot (also resets elapsed acq time)
+      ret = resetStructs(sdr, slotrelease(sdr, SLOT_LOST));
+      if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
 
-    // Acquisition --------------------------------------------------------
-    if (!sdr->flagacq) {
-      // memory allocation
-      if (acqpower!=NULL) free(acqpower);
-      acqpower=(double*)calloc(sizeof(double),sdr->nsamp*sdr->acq.nfreq);
+      // Pause a bit before continuing to reacquire
+      return RESETSLEEP;
+    }  // end if
+  } // end if
 
-      // fft correlation
-      buffloc=sdraqcuisition(sdr,acqpower);
+  // Check SV elevation (GPS only, the snapshot has no other satellites)
+  if (sdr->sys==SYS_GPS && sdr->elapsed_acq_time>60) {
+    // Pull values (navigation status snapshot)
+    el = getnavobs(sdr->prn, 10);
 
-      // Start timer. Note that this gets reset every time if flagacq = 0,
-      // but doesn't get called when flagacq is 1.
-      start_acq_timer = time(NULL);
-    }
+    // Check several nav flags
+    if (el < SV_EL_RESET_MASK) {
 
-    // Tracking -----------------------------------------------------------
-    if (sdr->flagacq) {
-      bufflocnow=sdrtracking(sdr,buffloc,cnt);
-      if (sdr->flagtrk) {
+      evlog(EV_RESETEL, sdr->prn, el, 0, 0);
 
-        // correlation output accumulation
-        cumsumcorr(&sdr->trk,sdr->nav.ocode[sdr->nav.ocodei]);
+      // Release the PRN and reset the slot (also resets elapsed acq time)
+      ret = resetStructs(sdr, slotrelease(sdr, SLOT_LOWEL));
+      if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
 
-        sdr->trk.flagloopfilter=0;
-        if (!sdr->nav.flagsync) {
-          pll(sdr,&sdr->trk.prm1,sdr->ctime);
-          dll(sdr,&sdr->trk.prm1,sdr->ctime);
-          sdr->trk.flagloopfilter=1;
-        }
-        else if (sdr->nav.swloop) {
-          pll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
-          dll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
-          sdr->trk.flagloopfilter=2;
+      // Pause a bit before continuing to reacquire
+      return RESETSLEEP;
+    }  // end if
+  } // end if
 
-          mlock(hobsmtx);
-          // calculate observation data
-          if (loopcnt%(SNSMOOTHMS/sdr->trk.loopms)==0) {
-            setobsdata(sdr,buffloc,cnt,&sdr->trk,1);
-          } else {
-            setobsdata(sdr,buffloc,cnt,&sdr->trk,0);
-          }
-          unmlock(hobsmtx);
+  // Check if mismatch between flagacq setting and obs use for pvt
+  //checkObsDelay(sdr->prn);
 
-          // Increment loop counter
-          loopcnt++;
+  // Acquisition --------------------------------------------------------
+  // Blind acquisition is paused while the supervisor sheds load
+  if (!sdr->flagacq && sdrstat.shed>=SHED_ACQ) {
+    return SUPINTMS;
+  }
+  if (!sdr->flagacq) {
+    // memory allocation
+    if (sdr->acqpower!=NULL) free(sdr->acqpower);
+    sdr->acqpower=(double*)calloc(sizeof(double),sdr->nsamp*sdr->acq.nfreq);
+
+    // fft correlation
+    t0 = probens();
+    sdr->buffloc=sdraqcuisition(sdr,sdr->acqpower);
+    probeadd(STAGE_ACQ, sdr->no-1, t0);
+    traceend(TRACE_ACQ, sdr->no-1, t0);
+
+    // Start timer. Note that this gets reset every time if flagacq = 0,
+    // but doesn't get called when flagacq is 1.
+    sdr->start_acq_timer = time(NULL);
+
+    // Acquisition process interval. A failed PRN hands the slot to a
+    // better free PRN (predicted visible, or not tried for longest)
+    if (!sdr->flagacq) {
+      int k = slotrelease(sdr, SLOT_ACQFAIL);
+      if (k==sdr->asset) return ACQSLEEP;
+      ret = resetStructs(sdr, k);
+      if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
+      return 0;
+    }
+    slotacquired(sdr);
+  }
 
-        } // end else if
+  // Tracking -----------------------------------------------------------
+  // Correlation, navigation, loop filters and observation data for one
+  // code period (or a block of them after bit sync), see sdrtracking()
+  sdr->bufflocnow=sdrtracking(sdr,&sdr->buffloc,&sdr->cnt,&sdr->loopcnt);
+  sdr->trk.buffloc=sdr->buffloc;
 
-        if (sdr->trk.flagloopfilter) clearcumsumcorr(&sdr->trk);
-        cnt++;
-        buffloc+=sdr->currnsamp;
+  // Wait for new data (needcnt) if none was available
+  return sdr->flagtrk?0:STEPWAITDATA;
+}
 
-      } // end tracking if (flagtrk)
-    } // end tracking if (flagacq)
+// SDR channel step -----------------------------------------------------------
+// run one step of the channel state machine and account its cpu time
+// args   : sdrch_t *sdr     I/O sdr channel struct
+// return : int                  delay before the next step (see chstep)
+//-----------------------------------------------------------------------------
+extern int sdrchstep(sdrch_t *sdr)
+{
+  unsigned long t0 = threadcpuus();
+  int delay = chstep(sdr);
 
-    sdr->trk.buffloc=buffloc;
-  } // end while
+  // Channel cpu time for the supervisor
+  __atomic_add_fetch(&sdr->cpuus,threadcpuus()-t0,__ATOMIC_RELAXED);
+  return delay;
+}
 
-  // Thread finished
+// SDR channel finish ---------------------------------------------------------
+// report the end of an sdr channel (thread or pool)
+// args   : sdrch_t *sdr     I   sdr channel struct
+// return : none
+//-----------------------------------------------------------------------------
+extern void sdrchfinish(sdrch_t *sdr)
+{
   if (sdr->flagacq) {
-    SDRPRINTF("SDR channel %s thread finished! Delay=%d [ms]\n",
-               sdr->satstr,(int)(bufflocnow-buffloc)/sdr->nsamp);
+    SDRPRINTF("SDR channel %s finished! Delay=%d [ms]\n",
+               sdr->satstr,(int)(sdr->bufflocnow-sdr->buffloc)/sdr->nsamp);
   } else {
-    SDRPRINTF("SDR channel %s thread finished!\n",sdr->satstr);
+    SDRPRINTF("SDR channel %s finished!\n",sdr->satstr);
   }
-
-  return THRETVAL;
 }
 
 //-----------------------------------------------------------------------------
@@ -572,6 +611,8 @@ extern void *datathread(void *arg)
     //    quitsdr(&sdrini,4);
     //}
 
+    probethread("sdr-data");
+
     // data grabber loop
     while (!sdrstat.stopflag) {
         if (rcvgrabdata(&sdrini)<0) {
@@ -583,47 +624,47 @@ extern void *datathread(void *arg)
 }
 
 //-----------------------------------------------------------------------------
-// Reset structures for sdrch
+// Reset structures for sdrch slot and assign PRN asset k (see slotrelease)
 //-----------------------------------------------------------------------------
-extern int resetStructs(void *arg)
+extern int resetStructs(void *arg, int k)
 {
-  // Declare channel struct to reset
+  // Declare channel struct (slot) to reset
   sdrch_t *sdr=(sdrch_t*)arg;
+  uint64_t t0=probens();
 
   mlock(hobsvecmtx);
-  // Set prn
+  // Set prn and slot
   int prn = sdr->prn;
-  int i = prn-1;
-  char bufferReset[MSG_LENGTH];
+  int i = sdr->no-1;
+  int acq = sdr->flagacq;
 
-  // Reset all values in sdrch[i]
+  __atomic_add_fetch(&sdrstat.chcnt[i].nreset,1,__ATOMIC_RELAXED);
+
+  // Reset all values in sdrch[i] (keep the thread handle). The channel
+  // buffers are freed first, the shared code assets are kept
+  thread_t hsdr = sdrch[i].hsdr;
+  if (sdrch[i].acqpower!=NULL) free(sdrch[i].acqpower);
+  freesdrch(&sdrch[i]);
   memset(&sdrch[i], 0, sizeof(sdrch_t));
+  sdrch[i].hsdr = hsdr;
 
   // Reset sdrstat flags (may be better to use nav timer by channel)
   sdrstat.azElCalculatedflag = 0;
 
-  // Initialize channel
-  if (initsdrch(i+1,sdrini.sys[i],sdrini.prn[i],sdrini.ctype[i],
-      sdrini.dtype[sdrini.ftype[i]-1],sdrini.ftype[i],
-      sdrini.f_gain[sdrini.ftype[i]-1],sdrini.f_bias[sdrini.ftype[i]-1],
-      sdrini.f_clock[sdrini.ftype[i]-1],sdrini.f_cf[sdrini.ftype[i]-1],
-      sdrini.f_sf[sdrini.ftype[i]-1],sdrini.f_if[sdrini.ftype[i]-1],
-      &sdrch[i])<0) {
+  // Initialize channel for the PRN asset
+  if (slotinitch(i,k)<0) {
 
       SDRPRINTF("error: initsdrch call in resetStructs\n");
       quitsdr(&sdrini,2);
       //return;
   }
   unmlock(hobsvecmtx);
+  traceend(TRACE_RESET, i, t0);
 
-  // Announce channel reset
-  snprintf(bufferReset, sizeof(bufferReset),
-     "%.3f  resetStructs: G%02d channel has been reset and will reacquire in 10s",
-     sdrstat.elapsedTime, prn);
-  add_message(bufferReset);
-
-  // Pause a bit before continuing to reacquire
-  sleepms(10000);
+  // Announce channel reset (PRN rotation after failed acquisition is quiet)
+  if (acq||sdrch[i].prn==prn) {
+    evlog(EV_RESET, prn, i+1, sdrch[i].prn, 0);
+  }
 
   return 0;
 }
@@ -636,17 +677,16 @@ extern int resetStructs(void *arg)
 extern int checkObsDelay(int prn)
 {
   // Initialize parameters
-  int i = prn-1;
+  sdrch_t *sdr = prnch(prn);
   int resetFlag = 0;
   int ret = 0;
-  char bufferReset[MSG_LENGTH];
 
   // Check to see if there is an obs for this PRN in obs_v. If not, leave
   // resetFlag equal to 1 and reset channel.
   mlock(hobsvecmtx);
   int nsat = sdrstat.nsatValid;
-  if (sdrch[i].flagacq==1) {
-    if (sdrch[i].elapsed_time_nav>90) {
+  if (sdr&&sdr->flagacq==1) {
+    if (sdr->elapsed_time_nav>90) {
       resetFlag = 1;
       for (int j=0;j<nsat;j++) {
         if (prn==sdrstat.obsValidList[j]) {
@@ -660,13 +700,10 @@ extern int checkObsDelay(int prn)
   // Reset the channel if mismatch between
   if (resetFlag) {
     //printf("checkObsDelay: resetting G%02d due to mismatch\n", prn);
-    snprintf(bufferReset, sizeof(bufferReset),
-     "%.3f  checkObsDelay: resetting G%02d due to mismatch",
-     sdrstat.elapsedTime, prn);
-    add_message(bufferReset);
+    evlog(EV_OBSDELAY, prn, 0, 0, 0);
 
-    ret = resetStructs(&sdrch[i]);
-    if (ret==-1) { printf("resetStructs: error\n"); }
+    ret = resetStructs(sdr, slotrelease(sdr, SLOT_LOST));
+    if (ret==-1) { evlog(EV_RESETERR,0,0,0,0); }
   }
 
   return 0;
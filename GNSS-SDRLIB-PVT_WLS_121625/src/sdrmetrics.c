@@ -0,0 +1,298 @@
+//-----------------------------------------------------------------------------
+// sdrmetrics.c : receiver metrics endpoint (Prometheus text exposition)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+
+#define METRICSBUFF   (256*1024)       // response buffer size (bytes)
+#define METRICSREQ    2048             // max request size (bytes)
+#define METRICSPOLLMS 500              // accept poll interval (ms)
+#define METRICSIOMS   1000             // client read/write timeout (ms)
+
+// response buffer
+typedef struct {
+        char *p;         // buffer
+        int n;           // length
+} metbuff_t;
+
+static int metricsfd=-1;           // listening socket
+static int metricsquit=0;          // server stop request
+static thread_t hmetricsthread;    // server thread
+
+// append to response ----------------------------------------------------------
+static void mprintf(metbuff_t *b, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if (b->n>=METRICSBUFF) return;
+    va_start(ap,fmt);
+    n=vsnprintf(b->p+b->n,METRICSBUFF-b->n,fmt,ap);
+    va_end(ap);
+    b->n=b->n+n<METRICSBUFF?b->n+n:METRICSBUFF;
+}
+
+// relaxed loads (values written by the real-time threads) ---------------------
+static double ldd(const double *p)
+{
+    double v;
+    __atomic_load(p,&v,__ATOMIC_RELAXED);
+    return v;
+}
+static int ldi(const int *p)
+{
+    return __atomic_load_n(p,__ATOMIC_RELAXED);
+}
+static uint64_t ldu(const uint64_t *p)
+{
+    return __atomic_load_n(p,__ATOMIC_RELAXED);
+}
+
+// metric header ---------------------------------------------------------------
+static void mhead(metbuff_t *b, const char *name, const char *type,
+                  const char *help)
+{
+    mprintf(b,"# HELP %s %s\n# TYPE %s %s\n",name,help,name,type);
+}
+
+// stage latency summary (seconds) ---------------------------------------------
+// quantiles from the stage histograms (sdrprobe.c), one channel or all (-1)
+static void msummary(metbuff_t *b, const char *name, int stage, int ch,
+                     const char *label)
+{
+    double stat[4];
+    uint64_t n=probestat(stage,ch,stat);
+
+    mprintf(b,"%s{%s%squantile=\"0.5\"} %.9f\n",name,label,*label?",":"",
+        stat[0]*1E-6);
+    mprintf(b,"%s{%s%squantile=\"0.99\"} %.9f\n",name,label,*label?",":"",
+        stat[1]*1E-6);
+    mprintf(b,"%s_sum%s%s%s %.9f\n",name,*label?"{":"",label,*label?"}":"",
+        stat[3]*n*1E-6);
+    mprintf(b,"%s_count%s%s%s %llu\n",name,*label?"{":"",label,*label?"}":"",
+        (unsigned long long)n);
+}
+
+// write metrics ---------------------------------------------------------------
+// all values are relaxed loads, probe histograms or the navigation snapshot
+// (seqlock): a scrape takes no mutex and never waits for the real-time threads
+static void metricsbody(metbuff_t *b)
+{
+    sdrnavsnap_t snap;
+    char lab[MAXSAT][32];
+    double ring=(double)MEMBUFFLEN*sdrstat.fendbuffsize,fill=0.0,r,rms=0.0;
+    uint64_t drop=0,lag;
+    int i,j,nch=sdrini.nch,prn;
+
+    for (i=0;i<nch;i++) {
+        snprintf(lab[i],sizeof(lab[i]),"ch=\"%d\",prn=\"%d\"",i+1,
+            ldi(&sdrch[i].prn));
+        drop+=ldu(&sdrstat.chcnt[i].dropsamp);
+        if (!ldi(&sdrch[i].flagacq)) continue;
+        lag=ldu(&sdrch[i].bufflocnow)-ldu(&sdrch[i].buffloc);
+        if (lag<(uint64_t)(2*ring)&&(r=lag/ring)>fill) fill=r;
+    }
+    getnavsnap(&snap);
+
+    // receiver
+    mhead(b,"gnss_sdr_uptime_seconds","gauge","Receiver run time");
+    mprintf(b,"gnss_sdr_uptime_seconds %.3f\n",ldd(&sdrstat.elapsedTime));
+    mhead(b,"gnss_sdr_frontend_blocks_total","counter",
+        "Front end blocks published to the ring buffer");
+    mprintf(b,"gnss_sdr_frontend_blocks_total %llu\n",
+        (unsigned long long)ldu(&sdrstat.buffcnt));
+    mhead(b,"gnss_sdr_ring_fill_ratio","gauge",
+        "Ring buffer fill of the slowest tracking channel (1: overrun)");
+    mprintf(b,"gnss_sdr_ring_fill_ratio %.4f\n",fill);
+    mhead(b,"gnss_sdr_dropped_samples_total","counter",
+        "Samples overwritten in the ring buffer before tracking");
+    mprintf(b,"gnss_sdr_dropped_samples_total %llu\n",(unsigned long long)drop);
+    mhead(b,"gnss_sdr_channel_load_ratio","gauge",
+        "Channel thread cpu load (fraction of the channel cpus)");
+    mprintf(b,"gnss_sdr_channel_load_ratio %.4f\n",ldd(&sdrstat.load));
+    mhead(b,"gnss_sdr_shed_level","gauge","Load shedding level");
+    mprintf(b,"gnss_sdr_shed_level %d\n",ldi(&sdrstat.shed));
+
+    // channels
+    mhead(b,"gnss_sdr_channel_cn0_dbhz","gauge","Channel C/N0 (dB-Hz)");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_cn0_dbhz{%s} %.2f\n",lab[i],
+            ldd(&sdrch[i].trk.cn0));
+    }
+    mhead(b,"gnss_sdr_channel_tracking","gauge","Channel acquired and tracking");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_tracking{%s} %d\n",lab[i],
+            ldi(&sdrch[i].flagacq)?1:0);
+    }
+    mhead(b,"gnss_sdr_channel_locked","gauge",
+        "Channel lock detector (C/N0 and PLL lock indicator)");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_locked{%s} %d\n",lab[i],
+            ldi(&sdrch[i].trk.flaglock)?1:0);
+    }
+    mhead(b,"gnss_sdr_channel_lag_ms","gauge",
+        "Channel samples behind the front end (ms)");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_lag_ms{%s} %.1f\n",lab[i],
+            ldd(&sdrch[i].trk.backlog));
+    }
+    mhead(b,"gnss_sdr_channel_overruns_total","counter",
+        "Channel ring buffer overruns");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_overruns_total{ch=\"%d\"} %llu\n",i+1,
+            (unsigned long long)ldu(&sdrstat.chcnt[i].overrun));
+    }
+    mhead(b,"gnss_sdr_channel_dropped_samples_total","counter",
+        "Channel samples overwritten before tracking");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_dropped_samples_total{ch=\"%d\"} %llu\n",
+            i+1,(unsigned long long)ldu(&sdrstat.chcnt[i].dropsamp));
+    }
+    mhead(b,"gnss_sdr_channel_resets_total","counter","Channel resets");
+    for (i=0;i<nch;i++) {
+        mprintf(b,"gnss_sdr_channel_resets_total{ch=\"%d\"} %llu\n",i+1,
+            (unsigned long long)ldu(&sdrstat.chcnt[i].nreset));
+    }
+    mhead(b,"gnss_sdr_acquisition_seconds","summary",
+        "Acquisition attempts and latency");
+    for (i=0;i<nch;i++) {
+        snprintf(lab[i],sizeof(lab[i]),"ch=\"%d\"",i+1);
+        msummary(b,"gnss_sdr_acquisition_seconds",STAGE_ACQ,i,lab[i]);
+    }
+    mhead(b,"gnss_sdr_correlator_seconds","summary",
+        "Correlator time per code period (epoch)");
+    for (i=0;i<nch;i++) {
+        msummary(b,"gnss_sdr_correlator_seconds",STAGE_COR,i,lab[i]);
+    }
+
+    // PVT
+    for (j=0;j<snap.nsatValid&&j<MAXSAT;j++) {
+        prn=snap.obsValidList[j];
+        if (prn>=1&&prn<=MAXSAT) rms+=snap.vk1_v[prn-1]*snap.vk1_v[prn-1];
+    }
+    if (snap.nsatValid>0) rms=sqrt(rms/snap.nsatValid);
+
+    mhead(b,"gnss_sdr_pvt_solve_seconds","summary","PVT solution time");
+    msummary(b,"gnss_sdr_pvt_solve_seconds",STAGE_PVT,-1,"");
+    mhead(b,"gnss_sdr_pvt_satellites_used","gauge","Satellites in the solution");
+    mprintf(b,"gnss_sdr_pvt_satellites_used %d\n",snap.nsatValid);
+    mhead(b,"gnss_sdr_pvt_gdop","gauge","Geometric dilution of precision");
+    mprintf(b,"gnss_sdr_pvt_gdop %.3f\n",snap.gdop);
+    mhead(b,"gnss_sdr_pvt_residual_rms_meters","gauge",
+        "RMS of the pseudorange residuals (m)");
+    mprintf(b,"gnss_sdr_pvt_residual_rms_meters %.3f\n",rms);
+}
+
+// serve one client ------------------------------------------------------------
+static void metricsclient(int fd, metbuff_t *b)
+{
+    struct timeval tv={METRICSIOMS/1000,(METRICSIOMS%1000)*1000};
+    char req[METRICSREQ+1],head[256];
+    int n=0,k,off,ok;
+
+    setsockopt(fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof(tv));
+    setsockopt(fd,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv));
+
+    // request line and headers
+    while (n<METRICSREQ) {
+        if ((k=recv(fd,req+n,METRICSREQ-n,0))<=0) break;
+        n+=k;
+        req[n]='\0';
+        if (strstr(req,"\r\n\r\n")||strstr(req,"\n\n")) break;
+    }
+    req[n]='\0';
+    ok=!strncmp(req,"GET /metrics ",13)||!strncmp(req,"GET / ",6);
+
+    b->n=0;
+    if (ok) metricsbody(b);
+    else mprintf(b,"not found\n");
+
+    k=snprintf(head,sizeof(head),"HTTP/1.0 %s\r\nContent-Type: text/plain; "
+        "version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+        ok?"200 OK":"404 Not Found",b->n);
+    send(fd,head,k,MSG_NOSIGNAL);
+    for (off=0;off<b->n;off+=k) {
+        if ((k=send(fd,b->p+off,b->n-off,MSG_NOSIGNAL))<=0) break;
+    }
+    close(fd);
+}
+
+// server thread ---------------------------------------------------------------
+static void *metricsthread(void *arg)
+{
+    struct pollfd pfd={metricsfd,POLLIN,0};
+    metbuff_t b={NULL,0};
+    int fd;
+
+    schedrole(ROLE_GUI);
+    probethread("sdr-metrics");
+
+    if (!(b.p=(char *)malloc(METRICSBUFF))) return THRETVAL;
+
+    while (!__atomic_load_n(&metricsquit,__ATOMIC_RELAXED)) {
+        if (poll(&pfd,1,METRICSPOLLMS)<=0) continue;
+        if ((fd=accept(metricsfd,NULL,NULL))<0) continue;
+        metricsclient(fd,&b);
+    }
+    free(b.p);
+    return THRETVAL;
+}
+
+// start metrics endpoint ------------------------------------------------------
+// listen on [METRICS] ADDR:PORT (loopback by default) and serve the metrics
+// at /metrics. PORT=0: no endpoint.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void metricsstart(void)
+{
+    struct sockaddr_in addr;
+    const char *host=sdrini.metricsaddr[0]?sdrini.metricsaddr:"127.0.0.1";
+    int on=1;
+
+    if (sdrini.metricsport<=0) return;
+
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_port=htons((unsigned short)sdrini.metricsport);
+    if (inet_pton(AF_INET,host,&addr.sin_addr)!=1) {
+        SDRPRINTF("error: metrics address %s\n",host);
+        return;
+    }
+    if ((metricsfd=socket(AF_INET,SOCK_STREAM|SOCK_CLOEXEC,0))<0) {
+        SDRPRINTF("error: metrics socket\n");
+        return;
+    }
+    setsockopt(metricsfd,SOL_SOCKET,SO_REUSEADDR,&on,sizeof(on));
+    if (bind(metricsfd,(struct sockaddr *)&addr,sizeof(addr))<0||
+        listen(metricsfd,4)<0) {
+        SDRPRINTF("error: metrics listen %s:%d\n",host,sdrini.metricsport);
+        close(metricsfd);
+        metricsfd=-1;
+        return;
+    }
+    if (pthread_create(&hmetricsthread,NULL,metricsthread,NULL)) {
+        close(metricsfd);
+        metricsfd=-1;
+        return;
+    }
+    SDRPRINTF("metrics: http://%s:%d/metrics\n",host,sdrini.metricsport);
+}
+
+// stop metrics endpoint -------------------------------------------------------
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void metricsstop(void)
+{
+    if (metricsfd<0) return;
+
+    __atomic_store_n(&metricsquit,1,__ATOMIC_RELAXED);
+    waitthread(hmetricsthread);
+    close(metricsfd);
+    metricsfd=-1;
+}
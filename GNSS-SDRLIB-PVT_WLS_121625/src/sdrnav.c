@@ -234,6 +234,7 @@ extern int checksync(double IP, double IPold, sdrnav_t *nav)
 extern int checkbit(double IP, int loopms, sdrnav_t *nav)
 {
     int diffi=nav->biti-nav->synci,syncflag=ON,polarity=1;
+    uint64_t *w,m;
 
     nav->swreset=OFF;
     nav->swsync=OFF;
@@ -263,10 +264,11 @@ extern int checkbit(double IP, int loopms, sdrnav_t *nav)
         }
         nav->bit=(nav->bitIP<0)?-polarity:polarity;
 
-        /* set bit*/
-        shiftdata(&nav->fbits[0],&nav->fbits[1],sizeof(int),
-            nav->flen+nav->addflen-1); /* shift to left */
-        nav->fbits[nav->flen+nav->addflen-1]=nav->bit; /* add last */
+        /* set bit (append to the packed bit ring) */
+        w=&nav->fbits[(nav->nfbits>>6)&nav->fbitsmask];
+        m=1ULL<<(63-(nav->nfbits&63));
+        if (nav->bit<0) *w|=m; else *w&=~m;
+        nav->nfbits++;
         nav->swsync=ON;
     }
     nav->cnt++;
@@ -274,6 +276,24 @@ extern int checkbit(double IP, int loopms, sdrnav_t *nav)
     return syncflag;
 }
 
+/* get frame bits --------------------------------------------------------------
+* extract bits of the current frame (last flen+addflen bits) from the packed
+* bit ring
+* args   : sdrnav_t *nav    I   navigation struct
+*          int    pos       I   first bit position in the frame (0: oldest)
+*          int    n         I   number of bits (1-64)
+* return : uint64_t             bits (right aligned, first bit is MSB, 1:-1)
+*-----------------------------------------------------------------------------*/
+extern uint64_t getfbits(const sdrnav_t *nav, int pos, int n)
+{
+    uint64_t k=nav->nfbits-(uint64_t)(nav->flen+nav->addflen-pos),w;
+    unsigned int i=(unsigned int)(k>>6),off=(unsigned int)(k&63);
+
+    w=nav->fbits[i&nav->fbitsmask]<<off;
+    if (off) w|=nav->fbits[(i+1)&nav->fbitsmask]>>(64-off);
+    return w>>(64-n);
+}
+
 /* decode foward error correction ----------------------------------------------
 * pre-decode foward error correction (before preamble detection)
 * args   : sdrnav_t *nav    I/O navigation struct
@@ -281,21 +301,24 @@ extern int checkbit(double IP, int loopms, sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern void predecodefec(sdrnav_t *nav)
 {
-    int i,j;
+    int i,j,n;
+    uint64_t w;
     unsigned char enc[NAVFLEN_SBAS+NAVADDFLEN_SBAS];
     unsigned char dec[94];
     int dec2[NAVFLEN_SBAS/2];
 
-    if (nav->ctype==CTYPE_L1CA) {
-        /* FEC is not used before preamble detection */
-        memcpy(nav->fbitsdec,nav->fbits,sizeof(int)*(nav->flen+nav->addflen));
-    }
+    /* GPS/QZS L1CA: FEC is not used, the frame is read from the bit ring */
+
     /* SBAS L1 / QZS L1SAIF */
     if (nav->ctype==CTYPE_L1SBAS) {
         /* 1/2 convolutional code */
         init_viterbi27_port(nav->fec,0);
-        for (i=0;i<NAVFLEN_SBAS+NAVADDFLEN_SBAS;i++)
-            enc[i]=(nav->fbits[i]==1)? 0:255;
+        for (i=0;i<NAVFLEN_SBAS+NAVADDFLEN_SBAS;i+=n) {
+            n=NAVFLEN_SBAS+NAVADDFLEN_SBAS-i;
+            if (n>64) n=64;
+            w=getfbits(nav,i,n);
+            for (j=0;j<n;j++) enc[i+j]=(w>>(n-1-j))&1?255:0;
+        }
         update_viterbi27_blk_port(nav->fec,enc,(nav->flen+nav->addflen)/2);
         chainback_viterbi27_port(nav->fec,dec,nav->flen/2,0);
         for (i=0;i<94;i++) {
@@ -317,23 +340,18 @@ extern void predecodefec(sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int paritycheck(sdrnav_t *nav)
 {
-    int i,j,stat=0,crc,bits[MAXBITS];
+    int i,stat=0,crc,bits[250];
     unsigned char bin[29]={0},pbin[3];
-
-    /* copy */
-    for (i=0;i<nav->flen+nav->addflen;i++)
-        bits[i]=nav->polarity*nav->fbitsdec[i];
+    uint32_t w;
 
     /* GPS/QZS L1CA parity check */
     if (nav->ctype==CTYPE_L1CA) {
-        /* checking all words */
+        /* checking all words (D29* D30* d1-d24 D25-D30) */
         for (i=0;i<10;i++) {
-            /* bit inversion */
-            if (bits[i*30+1]==-1) {
-                for (j=2;j<26;j++)
-                    bits[i*30+j]*=-1;
-            }
-            stat+=paritycheck_l1ca(&bits[i*30]);
+            w=(uint32_t)getfbits(nav,i*30,32);
+            if (nav->polarity<0) w=~w;
+            if (w&(1u<<30)) w^=0x3FFFFFC0; /* bit inversion (D30*) */
+            stat+=paritycheck_l1ca(w);
         }
         /* all parities are correct */
         if (stat==10) {
@@ -342,6 +360,7 @@ extern int paritycheck(sdrnav_t *nav)
     }
     /* SBAS L1 / QZS SAIF parity check */
     if (nav->ctype==CTYPE_L1SBAS) {
+        for (i=0;i<250;i++) bits[i]=nav->polarity*nav->fbitsdec[i];
         bits2byte(&bits[0],226,29,1,bin);
         bits2byte(&bits[226],24,3,0,pbin);
 
@@ -362,26 +381,28 @@ extern int paritycheck(sdrnav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int findpreamble(sdrnav_t *nav)
 {
-    int i,corr=0;
+    int i,nerr;
+    uint64_t w=0;
+
+    /* frame is not filled yet */
+    if (nav->nfbits<(uint64_t)(nav->flen+nav->addflen)) return 0;
 
     /* GPS/QZS L1CA */
     if (nav->ctype==CTYPE_L1CA) {
-        for (i=0;i<nav->prelen;i++)
-            corr+=(nav->fbitsdec[nav->addflen+i]*nav->prebits[i]);
+        w=getfbits(nav,nav->addflen,nav->prelen);
     }
 
     /* L1-SBAS/SAIF */
     /* check 2 preambles */
     if (nav->ctype==CTYPE_L1SBAS) {
-        for (i=0;i<nav->prelen/2;i++) {
-            corr+=(nav->fbitsdec[i    ]*nav->prebits[ 0+i]);
-            corr+=(nav->fbitsdec[i+250]*nav->prebits[ 8+i]);
-        }
+        for (i=0;i<nav->prelen/2;i++) w=(w<<1)|(nav->fbitsdec[i    ]<0);
+        for (i=0;i<nav->prelen/2;i++) w=(w<<1)|(nav->fbitsdec[i+250]<0);
     }
 
-    /* check preamble match */
-    if (abs(corr)==nav->prelen) { /* preamble matched */
-        nav->polarity=corr>0?1:-1; /* set bit polarity */
+    /* check preamble match (bit errors, 0 or prelen: inverted polarity) */
+    nerr=__builtin_popcountll(w^nav->prepat);
+    if (nerr==0||nerr==nav->prelen) { /* preamble matched */
+        nav->polarity=nerr==0?1:-1; /* set bit polarity */
         /* parity check */
         if (paritycheck(nav)) {
             return 1;
@@ -135,31 +135,25 @@ int decode_frame_l1ca(const uint8_t *buff, sdreph_t *eph)
     return id;
 }
 /* parity check ----------------------------------------------------------------
-* GPS/QZS L1CA parity check function
-* args   : int    *bits     I   navigation bits (2+30 bits)
+* GPS/QZS L1CA parity check function (ICD-GPS-200 20.3.5.2). the -1/1 bit
+* products of the parity equations are the parities (xor) of the 1/0 bits
+* selected by the masks
+* args   : uint32_t word    I   navigation word (D29* D30* d1-d24 D25-D30,
+*                               D29* is MSB, 1: bit -1, data bits inverted)
 * return : int                  1:okay 0: wrong parity
 *-----------------------------------------------------------------------------*/
-extern int paritycheck_l1ca(int *bits)
+extern int paritycheck_l1ca(uint32_t word)
 {
-    int i,stat=0;
-    int pbits[6];
+    static const uint32_t mask[6]={ /* D25-D30 */
+        0xBB1F3480,0x5D8F9A40,0xAEC7CD00,0x5763E680,0x6BB1F340,0x8B7A89C0
+    };
+    uint32_t p=0;
+    int i;
 
     /* calculate parity bits*/
-    pbits[0]=bits[0]*bits[2]*bits[3]*bits[4]*bits[6]*bits[7 ]*bits[11]*bits[12]*
-        bits[13]*bits[14]*bits[15]*bits[18]*bits[19]*bits[21]*bits[24];
-    pbits[1]=bits[1]*bits[3]*bits[4]*bits[5]*bits[7]*bits[8 ]*bits[12]*bits[13]*
-        bits[14]*bits[15]*bits[16]*bits[19]*bits[20]*bits[22]*bits[25];
-    pbits[2]=bits[0]*bits[2]*bits[4]*bits[5]*bits[6]*bits[8 ]*bits[9 ]*bits[13]*
-        bits[14]*bits[15]*bits[16]*bits[17]*bits[20]*bits[21]*bits[23];
-    pbits[3]=bits[1]*bits[3]*bits[5]*bits[6]*bits[7]*bits[9 ]*bits[10]*bits[14]*
-        bits[15]*bits[16]*bits[17]*bits[18]*bits[21]*bits[22]*bits[24];
-    pbits[4]=bits[1]*bits[2]*bits[4]*bits[6]*bits[7]*bits[8 ]*bits[10]*bits[11]*
-        bits[15]*bits[16]*bits[17]*bits[18]*bits[19]*bits[22]*bits[23]*bits[25];
-    pbits[5]=bits[0]*bits[4]*bits[6]*bits[7]*bits[9]*bits[10]*bits[11]*bits[12]*
-        bits[14]*bits[16]*bits[20]*bits[23]*bits[24]*bits[25];
-
-    for (i=0;i<6;i++) stat+=(pbits[i]-bits[26+i]);
-    if (stat==0) return 1; /* parity is matched */
+    for (i=0;i<6;i++) p=(p<<1)|(uint32_t)__builtin_parity(word&mask[i]);
+
+    if (p==(word&0x3F)) return 1; /* parity is matched */
 
     return 0;
 }
@@ -170,17 +164,16 @@ extern int paritycheck_l1ca(int *bits)
 *-----------------------------------------------------------------------------*/
 extern int decode_l1ca(sdrnav_t *nav)
 {
-    int i,j,id=0;
-    uint8_t bin[38];
+    int i,id=0;
+    uint32_t w;
+    uint8_t bin[38]={0};
 
-    /* bit inversion */
+    /* bit inversion (D30*) and packing of the 30 bit words */
     for (i=0;i<10;i++) {
-        if (nav->fbitsdec[i*30+1]==-1) {
-            for (j=2;j<26;j++) 
-                nav->fbitsdec[i*30+j]*=-1;
-        }
+        w=(uint32_t)getfbits(nav,i*30,32);
+        if (w&(1u<<30)) w^=0x3FFFFFC0;
+        setbitu(bin,i*30,30,w&0x3FFFFFFF);
     }
-    bits2byte(&nav->fbitsdec[nav->addflen],nav->flen,38,0,bin);
 
     /* decode navigation data */
     id=decode_frame_l1ca(bin,&nav->sdreph);
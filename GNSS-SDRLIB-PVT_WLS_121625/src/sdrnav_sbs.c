@@ -120,10 +120,12 @@ extern int decode_l1sbas(sdrnav_t *nav)
     bits2byte(bits,250,32,0,nav->sbas.msg);
     decode_msg_sbas(nav->sbas.msg,&nav->sbas);
 
-    /* tentative: get tow from other channel */
-    if (sdrini.nch>1&&sdrch[sdrini.nch-2].nav.sdreph.week_gpst!=0) {
-        nav->sbas.tow=sdrch[sdrini.nch-2].trk.tow[0];
-        nav->sbas.week=sdrch[sdrini.nch-2].nav.sdreph.week_gpst;
+    /* tentative: get tow from a GPS channel with decoded navigation data */
+    for (i=0;i<sdrini.nch;i++) {
+        if (sdrch[i].sys!=SYS_GPS||sdrch[i].nav.sdreph.week_gpst==0) continue;
+        nav->sbas.tow=sdrch[i].trk.tow[0];
+        nav->sbas.week=sdrch[i].nav.sdreph.week_gpst;
+        break;
     }
 
     /* generate NovAtel sbas message */
@@ -0,0 +1,185 @@
+//-----------------------------------------------------------------------------
+// sdrpool.c : SDR channel worker pool (work stealing)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+static sdrworker_t worker[MAXWORKER]; // pool workers
+static int nworker=0;                 // number of pool workers
+
+// push channel to deque tail --------------------------------------------------
+static void pushch(sdrworker_t *w, int ch)
+{
+    mlock(w->mtx);
+    w->deque[(w->head+w->n++)%MAXSAT]=ch;
+    unmlock(w->mtx);
+}
+
+// pop channel from deque head (owner) -----------------------------------------
+static int popch(sdrworker_t *w)
+{
+    int ch=-1;
+
+    mlock(w->mtx);
+    if (w->n>0) {
+        ch=w->deque[w->head];
+        w->head=(w->head+1)%MAXSAT;
+        w->n--;
+    }
+    unmlock(w->mtx);
+    return ch;
+}
+
+// steal channel from deque tail of another worker -----------------------------
+static int stealch(sdrworker_t *w)
+{
+    int i,ch=-1;
+    sdrworker_t *v;
+
+    for (i=1;i<nworker&&ch<0;i++) {
+        v=&worker[(w->no+i)%nworker];
+        if (__atomic_load_n(&v->n,__ATOMIC_RELAXED)<=0) continue;
+        mlock(v->mtx);
+        if (v->n>0) ch=v->deque[(v->head+--v->n)%MAXSAT];
+        unmlock(v->mtx);
+    }
+    if (ch>=0) w->nsteal++;
+    return ch;
+}
+
+// add channel to the waiting list (owner) -------------------------------------
+// wake: wake time (us), need: buffer count which also wakes it (0: none)
+static void waitch(sdrworker_t *w, int ch, unsigned long wake, uint64_t need)
+{
+    w->timed[w->ntimed]=ch;
+    w->need[w->ntimed]=need;
+    w->wake[w->ntimed++]=wake;
+}
+
+// worker thread ---------------------------------------------------------------
+// run channel steps from the own deque, steal from other workers when empty
+// args   : void   *arg      I   worker struct
+// return : none
+// note : a channel is in exactly one place at a time (a deque, a waiting list
+//        or being stepped by one worker), so its state is never shared between
+//        workers. a stolen channel stays with the thief (load balancing).
+//-----------------------------------------------------------------------------
+static void *workerthread(void *arg)
+{
+    sdrworker_t *w=(sdrworker_t*)arg;
+    unsigned long now,wake;
+    uint64_t buffcnt;
+    int i,ch,delay;
+    char name[16];
+
+    schedrole(ROLE_CHANNEL);
+    snprintf(name,sizeof(name),"sdr-pool%02d",w->no);
+    probethread(name);
+
+    while (!sdrstat.stopflag) {
+        now=tickgetus();
+        buffcnt=__atomic_load_n(&sdrstat.buffcnt,__ATOMIC_RELAXED);
+
+        // waiting channels which are due (time or data) to the deque
+        for (i=0;i<w->ntimed;) {
+            if ((long)(w->wake[i]-now)<=0||
+                (w->need[i]&&buffcnt>=w->need[i])) {
+                pushch(w,w->timed[i]);
+                w->ntimed--;
+                w->timed[i]=w->timed[w->ntimed];
+                w->need[i]=w->need[w->ntimed];
+                w->wake[i]=w->wake[w->ntimed];
+            }
+            else i++;
+        }
+        // own channel or steal one
+        if ((ch=popch(w))<0&&(ch=stealch(w))<0) {
+            wake=now+POOLIDLEMS*1000UL;
+            for (i=0;i<w->ntimed;i++) {
+                if ((long)(w->wake[i]-wake)<0) wake=w->wake[i];
+            }
+            // next published data (to move own channels or steal) or timer
+            rcvwaitbuff(buffcnt+1,(int)((wake-now+999)/1000));
+            w->nidle++;
+            continue;
+        }
+        // channel step (acquisition or tracking)
+        delay=sdrchstep(&sdrch[ch]);
+        w->nstep++;
+
+        if (delay==STEPWAITDATA) {
+            waitch(w,ch,tickgetus()+DATAWAITMS*1000UL,sdrch[ch].needcnt);
+        }
+        else if (delay>0) waitch(w,ch,tickgetus()+delay*1000UL,0);
+        else pushch(w,ch);
+    }
+    return THRETVAL;
+}
+
+// start worker pool -----------------------------------------------------------
+// create the pool workers (one per channel cpu, [THREADS] CHANNELCPUS or the
+// process cpus, unless [THREADS] WORKERS is set) and distribute the L1
+// channels over them round robin
+// args   : none
+// return : int                  number of workers (-1: error)
+//-----------------------------------------------------------------------------
+extern int poolstart(void)
+{
+    int i,n=0,ret;
+    unsigned long now=tickgetus();
+
+    // number of workers (cpus the workers are placed on, see schedrole())
+    if ((nworker=sdrini.nworker)<=0) nworker=rolecpus(ROLE_CHANNEL);
+    if (nworker>MAXWORKER) nworker=MAXWORKER;
+    if (nworker>sdrini.nch) nworker=sdrini.nch;
+    if (nworker<1) nworker=1;
+
+    for (i=0;i<nworker;i++) {
+        memset(&worker[i],0,sizeof(sdrworker_t));
+        worker[i].no=i;
+        initmlock(worker[i].mtx);
+    }
+    // channels start delayed one by one (as channel threads)
+    for (i=0;i<sdrini.nch;i++) {
+        if (sdrch[i].ctype!=CTYPE_L1CA&&sdrch[i].ctype!=CTYPE_L1SBAS) continue;
+        waitch(&worker[n++%nworker],i,now+sdrch[i].no*500*1000UL,0);
+    }
+    for (i=0;i<nworker;i++) {
+        ret=pthread_create(&worker[i].hworker,NULL,workerthread,&worker[i]);
+        if (ret) {
+            printf(BRED "Create for worker thread failed: %s\n" reset,
+                   strerror(ret));
+            sdrstat.stopflag=ON;
+            nworker=i;
+            return -1;
+        }
+    }
+    SDRPRINTF("SDR channel worker pool: %d workers, %d channels\n",nworker,n);
+    return nworker;
+}
+
+// wait worker pool ------------------------------------------------------------
+// join the pool workers and report the channels and worker counters
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void poolwait(void)
+{
+    int i;
+
+    for (i=0;i<nworker;i++) {
+        waitthread(worker[i].hworker);
+    }
+    for (i=0;i<sdrini.nch;i++) {
+        if (sdrch[i].ctype!=CTYPE_L1CA&&sdrch[i].ctype!=CTYPE_L1SBAS) continue;
+        sdrchfinish(&sdrch[i]);
+    }
+    for (i=0;i<nworker;i++) {
+        SDRPRINTF("worker %2d: steps %llu stolen %llu idle %llu\n",i,
+            (unsigned long long)worker[i].nstep,
+            (unsigned long long)worker[i].nsteal,
+            (unsigned long long)worker[i].nidle);
+        delmlock(worker[i].mtx);
+    }
+}
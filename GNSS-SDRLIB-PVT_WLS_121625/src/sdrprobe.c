@@ -0,0 +1,223 @@
+//-----------------------------------------------------------------------------
+// sdrprobe.c : pipeline stage latency probes and thread cpu accounting
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+#define MAXPROBETHREAD 128             // max named threads
+
+// stage names
+static const char *stagename[STAGES]={"ACQ","COR","NAV","SYNC","PVT"};
+
+// stage latency histogram (single writer: the thread running the stage, own
+// cache lines since adjacent channels are written by different workers)
+typedef struct {
+        uint64_t bin[PROBEBINS]; // counts per bucket (4 per octave of ns)
+        uint64_t sum;    // sum of latencies (ns)
+        uint64_t max;    // max latency (ns)
+} __attribute__((aligned(CACHELINE))) sdrhist_t;
+
+// named thread (cpu time from its CLOCK_THREAD_CPUTIME_ID clock)
+typedef struct {
+        char name[16];   // thread name (pthread_setname_np)
+        clockid_t cid;   // thread cpu clock
+        double cpu;      // cpu time at the last sample (s)
+} sdrthr_t;
+
+// per channel (slot) histograms, [MAXSAT]: stages outside the channels
+static sdrhist_t hist[STAGES][MAXSAT+1];
+static sdrthr_t thr[MAXPROBETHREAD]; // named threads
+static int nthr=0;                  // number of named threads
+static __thread int thrnamed=0;     // calling thread named
+
+// probe time ------------------------------------------------------------------
+// args   : none
+// return : uint64_t             time (ns, CLOCK_MONOTONIC_RAW, vdso)
+//-----------------------------------------------------------------------------
+extern uint64_t probens(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+// histogram bucket ------------------------------------------------------------
+// 0-3 ns linear, then 4 buckets per octave (2 mantissa bits)
+static int bucket(uint64_t ns)
+{
+    int msb,i;
+
+    if (ns<4) return (int)ns;
+    msb=63-__builtin_clzll(ns);
+    i=(msb-1)*4+(int)((ns>>(msb-2))&3);
+    return i<PROBEBINS?i:PROBEBINS-1;
+}
+
+// bucket center (ns) ----------------------------------------------------------
+static double bucketns(int i)
+{
+    int e;
+
+    if (i<4) return i;
+    e=i/4-1;
+    return ldexp(4+i%4+0.5,e);
+}
+
+// add stage latency -----------------------------------------------------------
+// record the latency of a stage since t0 (probens()). only the thread running
+// the stage for the channel writes its histogram (relaxed stores for readers)
+// args   : int    stage     I   pipeline stage (STAGE_???)
+//          int    ch        I   channel (slot) index (-1: not a channel)
+//          uint64_t t0      I   stage start (ns)
+// return : none
+//-----------------------------------------------------------------------------
+extern void probeadd(int stage, int ch, uint64_t t0)
+{
+    sdrhist_t *h=&hist[stage][ch<0||ch>=MAXSAT?MAXSAT:ch];
+    uint64_t ns=probens()-t0;
+    int i=bucket(ns);
+
+    __atomic_store_n(&h->bin[i],h->bin[i]+1,__ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum,h->sum+ns,__ATOMIC_RELAXED);
+    if (ns>h->max) __atomic_store_n(&h->max,ns,__ATOMIC_RELAXED);
+}
+
+// stage statistics ------------------------------------------------------------
+// percentiles of a stage (bucket centers) for one channel or all of them
+// args   : int    stage     I   pipeline stage (STAGE_???)
+//          int    ch        I   channel (slot) index (-1: all)
+//          double *stat     O   p50,p99,max,mean (us)
+// return : uint64_t             number of samples
+//-----------------------------------------------------------------------------
+extern uint64_t probestat(int stage, int ch, double *stat)
+{
+    uint64_t bin[PROBEBINS]={0},n=0,sum=0,max=0,c,k50,k99;
+    int i,j,j0=ch<0?0:ch,j1=ch<0?MAXSAT:ch;
+
+    for (j=j0;j<=j1;j++) {
+        const sdrhist_t *h=&hist[stage][j];
+        for (i=0;i<PROBEBINS;i++) {
+            bin[i]+=__atomic_load_n(&h->bin[i],__ATOMIC_RELAXED);
+        }
+        sum+=__atomic_load_n(&h->sum,__ATOMIC_RELAXED);
+        c=__atomic_load_n(&h->max,__ATOMIC_RELAXED);
+        if (c>max) max=c;
+    }
+    for (i=0;i<PROBEBINS;i++) n+=bin[i];
+    stat[0]=stat[1]=stat[2]=stat[3]=0.0;
+    if (n==0) return 0;
+
+    k50=(n+1)/2; k99=n-n/100;
+    for (i=0,c=0;i<PROBEBINS;i++) {
+        if (c<k50&&c+bin[i]>=k50) stat[0]=bucketns(i)*1E-3;
+        if (c<k99&&c+bin[i]>=k99) stat[1]=bucketns(i)*1E-3;
+        c+=bin[i];
+    }
+    stat[2]=max*1E-3;
+    stat[3]=(double)sum/n*1E-3;
+    return n;
+}
+
+// name calling thread ---------------------------------------------------------
+// set the thread name (pthread_setname_np, max 15 chars) and register the
+// thread cpu clock for the cpu accounting. once per thread.
+// args   : char   *name     I   thread name
+// return : none
+//-----------------------------------------------------------------------------
+extern void probethread(const char *name)
+{
+    int i;
+
+    if (thrnamed) return;
+    thrnamed=1;
+
+    pthread_setname_np(pthread_self(),name);
+
+    if ((i=__atomic_fetch_add(&nthr,1,__ATOMIC_RELAXED))>=MAXPROBETHREAD) {
+        nthr=MAXPROBETHREAD;
+        return;
+    }
+    snprintf(thr[i].name,sizeof(thr[i].name),"%s",name);
+    if (pthread_getcpuclockid(pthread_self(),&thr[i].cid)) {
+        thr[i].cid=(clockid_t)-1;
+    }
+}
+
+// sample thread cpu times -----------------------------------------------------
+// read the cpu clocks of the named threads (called periodically while the
+// threads run, the last sample is kept for the summary)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void probesample(void)
+{
+    struct timespec ts;
+    int i,n=__atomic_load_n(&nthr,__ATOMIC_RELAXED);
+
+    for (i=0;i<n&&i<MAXPROBETHREAD;i++) {
+        if (thr[i].cid==(clockid_t)-1||clock_gettime(thr[i].cid,&ts)) continue;
+        thr[i].cpu=ts.tv_sec+ts.tv_nsec*1E-9;
+    }
+}
+
+// stage latency line ----------------------------------------------------------
+// p50/p99/max (us) of all stages for the status window
+// args   : char   *buff     O   line
+//          int    size      I   line size
+// return : none
+//-----------------------------------------------------------------------------
+extern void probeline(char *buff, int size)
+{
+    double stat[4];
+    int i,n;
+
+    n=snprintf(buff,size,"Latency p50/p99/max (us):");
+    for (i=0;i<STAGES&&n<size;i++) {
+        if (!probestat(i,-1,stat)) continue;
+        n+=snprintf(buff+n,size-n,"  %s %.0f/%.0f/%.0f",stagename[i],stat[0],
+            stat[1],stat[2]);
+    }
+}
+
+// probe summary ---------------------------------------------------------------
+// write the stage latencies (all channels and per channel) and the thread cpu
+// times to the summary file ([OUTPUT] STATSFILE) at shutdown
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void probesummary(void)
+{
+    FILE *fp;
+    double stat[4];
+    uint64_t n;
+    int i,j;
+
+    if (!sdrini.statsfile[0]) return;
+    if (!(fp=fopen(sdrini.statsfile,"w"))) {
+        SDRPRINTF("error: stats file %s\n",sdrini.statsfile);
+        return;
+    }
+    fprintf(fp,"# stage latency (us), run time %.1f s\n",sdrstat.elapsedTime);
+    fprintf(fp,"%-5s %-4s %-4s %12s %10s %10s %10s %10s\n","stage","ch",
+        "prn","count","mean","p50","p99","max");
+    for (i=0;i<STAGES;i++) {
+        if (!(n=probestat(i,-1,stat))) continue;
+        fprintf(fp,"%-5s %-4s %-4s %12llu %10.1f %10.1f %10.1f %10.1f\n",
+            stagename[i],"all","",(unsigned long long)n,stat[3],stat[0],
+            stat[1],stat[2]);
+        for (j=0;j<sdrini.nch;j++) {
+            if (!(n=probestat(i,j,stat))) continue;
+            fprintf(fp,"%-5s %-4d %-4s %12llu %10.1f %10.1f %10.1f %10.1f\n",
+                stagename[i],j+1,sdrch[j].satstr,(unsigned long long)n,
+                stat[3],stat[0],stat[1],stat[2]);
+        }
+    }
+    fprintf(fp,"\n# thread cpu time (s)\n");
+    for (i=0;i<nthr&&i<MAXPROBETHREAD;i++) {
+        fprintf(fp,"%-16s %10.2f %5.1f%%\n",thr[i].name,thr[i].cpu,
+            sdrstat.elapsedTime>0.0?100.0*thr[i].cpu/sdrstat.elapsedTime:0.0);
+    }
+    fclose(fp);
+    SDRPRINTF("stage latency summary: %s\n",sdrini.statsfile);
+}
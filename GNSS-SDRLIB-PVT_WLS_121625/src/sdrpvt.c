@@ -78,12 +78,11 @@ extern int pvtProcessor(void)
     // Update transmit time and get satellite position
     transmitTime = rcvr_tow - tau;
     mlock(hobsvecmtx);
-    ret = satPos(&sdrch[sdrstat.obsValidList[i]-1].nav.sdreph, transmitTime, xs_v,
-             &svClkCorr);
+    sdrch_t *ch = prnch(sdrstat.obsValidList[i]);
+    ret = ch ? satPos(&ch->nav.sdreph, transmitTime, xs_v, &svClkCorr) : -1;
     unmlock(hobsvecmtx);
     if (ret != 0) {
-      printf("Function satPos has xs NaN for G%02d, exiting pvtProcessor\n",
-             sdrstat.obsValidList[i]);
+      evlog(EV_SATPOSNAN, sdrstat.obsValidList[i], 0, 0, 0);
       goto errorDetected;
     }
 
@@ -123,12 +122,12 @@ extern int pvtProcessor(void)
   if (sdrini.ekfFilterOn==0) {
     ret = blsFilter(Xs_v, prSvClkCorr_v, numSat, xyzdt_v, &gdop);
   } else {
-    printf("Error, EKF not installed.\n");
+    evlog(EV_NOEKF,0,0,0,0);
   }
 
   // If x calculated as NaN, exit pvtProcessor
   if (isnan(xyzdt_v[0]) || isnan(xyzdt_v[1]) || isnan(xyzdt_v[2])) {
-    printf("Function estRcvrPosn gets NaN for xu, exiting pvtProcessor\n");
+    evlog(EV_POSNAN,0,0,0,0);
     goto errorDetected;
   }
 
@@ -312,7 +311,7 @@ extern int blsFilter(double *X_v, double *pr_v, int numSat,
       }
       ret = topocent(X, dx, &az, &el, &D);
       if (ret!=0) {
-        printf("topocent function: error\n");
+        evlog(EV_TOPOCENT,0,0,0,0);
       }
       sdrstat.azElCalculatedflag = 1;  // Set azEl flag
 
@@ -330,7 +329,7 @@ extern int blsFilter(double *X_v, double *pr_v, int numSat,
       ret = tropo(sin(el*D2R), 0.0, 1013.0, 293.0, 50.0,
                                0.0, 0.0, 0.0, &trop);
       if (ret!=0) {
-        printf("tropo function: error\n");
+        evlog(EV_TROPO,0,0,0,0);
       }
 
       } // end of if else
@@ -376,7 +375,7 @@ extern int blsFilter(double *X_v, double *pr_v, int numSat,
     // Check for viable inverse (if det equals zero, rank too low)
     det = nml_mat_det(lupAtA);
     if (fabs(det)<detTol) {
-      printf("Exiting estRcvrPosn, determinant=%lf\n", det);
+      evlog(EV_DET,det,0,0,0);
       goto errorDetected;
     }
 
@@ -750,7 +749,6 @@ extern void precheckObs()
   int prn = 0;
   int i = 0;
   double tol = 1e-15; // tolerance for checking if non-zero
-  char buffer[MSG_LENGTH];
 
   // Set mutex, loop through all obs
   mlock(hobsvecmtx);
@@ -760,85 +758,64 @@ extern void precheckObs()
     // Check that SNR level is above threshold
     if (sdrstat.obs_v[(prn-1) * 11 + 8] < SNR_PVT_THRES) {
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  preCheckObs: G%02d has SNR:%.1f\n",
-        sdrstat.elapsedTime, prn,
-        sdrstat.obs_v[(prn-1) * 11 + 8]);
-      add_message(buffer);
+      evlog(EV_PRESNR, prn, sdrstat.obs_v[(prn-1) * 11 + 8], 0, 0);
       updateRequired = 1;
     } //end if
 
     // Check that GPS Week is non-zero
     if (sdrstat.obs_v[(prn-1) * 11 + 7] < GPS_WEEK) {
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  preCheckObs: G%02d has Week:%d\n",
-        sdrstat.elapsedTime, prn,
-         (int)sdrstat.obs_v[(prn-1) * 11 + 7]);
-      add_message(buffer);
+      evlog(EV_PREWEEK, prn, (int)sdrstat.obs_v[(prn-1) * 11 + 7], 0, 0);
       updateRequired = 1;
     } // end if
 
     // Check that TOW is non-zero
     if (sdrstat.obs_v[(prn-1) * 11 + 6] < 1.0) {
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  preCheckObs: G%02d has ToW:%.1f\n",
-        sdrstat.elapsedTime, prn,
-         sdrstat.obs_v[(prn-1) * 11 + 6]);
-      add_message(buffer);
+      evlog(EV_PRETOW, prn, sdrstat.obs_v[(prn-1) * 11 + 6], 0, 0);
       updateRequired = 1;
     } // end if
 
     // Check that the PR is not too low
     if (sdrstat.obs_v[(prn-1) * 11 + 5] < LOW_PR) {
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  preCheckObs: G%02d has Low PR:%.1f\n",
-        sdrstat.elapsedTime, prn,
-         sdrstat.obs_v[(prn-1) * 11 + 5]);
-      add_message(buffer);
+      evlog(EV_PRELOWPR, prn, sdrstat.obs_v[(prn-1) * 11 + 5], 0, 0);
       updateRequired = 1;
     } // end if
 
     // Check that the PR is not too high
     if (sdrstat.obs_v[(prn-1) * 11 + 5] > HIGH_PR) {
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  preCheckObs: G%02d has High PR:%.1f\n",
-        sdrstat.elapsedTime, prn,
-         sdrstat.obs_v[(prn-1) * 11 + 5]);
-      add_message(buffer);
+      evlog(EV_PREHIGHPR, prn, sdrstat.obs_v[(prn-1) * 11 + 5], 0, 0);
       updateRequired = 1;
     } // end if
 
     // Check ephemeris values for reasonableness
-    if ( (sdrch[prn-1].nav.sdreph.eph.toes<1.0) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.A)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.e)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.M0)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.omg)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.i0)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.OMG0)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.deln)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.idot)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.OMGd)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.cuc)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.cus)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.crc)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.crs)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.cic)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.cis)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.f0)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.f1)<tol) ||
-         (fabs(sdrch[prn-1].nav.sdreph.eph.tgd[0])<tol) ){
+    sdrch_t *ch = prnch(prn);
+    if ( (ch==NULL) ||
+         (ch->nav.sdreph.eph.toes<1.0) ||
+         (fabs(ch->nav.sdreph.eph.A)<tol) ||
+         (fabs(ch->nav.sdreph.eph.e)<tol) ||
+         (fabs(ch->nav.sdreph.eph.M0)<tol) ||
+         (fabs(ch->nav.sdreph.eph.omg)<tol) ||
+         (fabs(ch->nav.sdreph.eph.i0)<tol) ||
+         (fabs(ch->nav.sdreph.eph.OMG0)<tol) ||
+         (fabs(ch->nav.sdreph.eph.deln)<tol) ||
+         (fabs(ch->nav.sdreph.eph.idot)<tol) ||
+         (fabs(ch->nav.sdreph.eph.OMGd)<tol) ||
+         (fabs(ch->nav.sdreph.eph.cuc)<tol) ||
+         (fabs(ch->nav.sdreph.eph.cus)<tol) ||
+         (fabs(ch->nav.sdreph.eph.crc)<tol) ||
+         (fabs(ch->nav.sdreph.eph.crs)<tol) ||
+         (fabs(ch->nav.sdreph.eph.cic)<tol) ||
+         (fabs(ch->nav.sdreph.eph.cis)<tol) ||
+         (fabs(ch->nav.sdreph.eph.f0)<tol) ||
+         (fabs(ch->nav.sdreph.eph.f1)<tol) ||
+         (fabs(ch->nav.sdreph.eph.tgd[0])<tol) ){
 
       // Mark obs for removal and set updateRequired flag
       sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-      snprintf(buffer, sizeof(buffer),
-        "%.3f  precheckEPH: G%02d tagged for removal for eph error\n",
-        sdrstat.elapsedTime, prn);
-      add_message(buffer);
+      evlog(EV_PREEPH, prn, 0, 0, 0);
       updateRequired = 1;
     } // end if
 
@@ -847,10 +824,7 @@ extern void precheckObs()
     if (sdrstat.azElCalculatedflag) {
       if (sdrstat.obs_v[(prn-1) * 11 + 10] < SV_EL_PVT_MASK) {
         sdrstat.obs_v[(prn-1) * 11 + 1] = 0;
-        snprintf(buffer, sizeof(buffer),
-            "%.3f  precheckObs: G%02d tagged for removal with el of %.1f\n",
-             sdrstat.elapsedTime, prn, sdrstat.obs_v[(prn-1) * 11 + 10]);
-        add_message(buffer);
+        evlog(EV_PREEL, prn, sdrstat.obs_v[(prn-1) * 11 + 10], 0, 0);
         updateRequired = 1;
       } // end if
     } // end if
@@ -864,7 +838,7 @@ extern void precheckObs()
   // Update nsatValid and obsValidList
   if (updateRequired) {
     ret = updateObsList();
-    if (ret==-1) { printf("updateObsList: error\n"); }
+    if (ret==-1) { evlog(EV_OBSLIST,0,0,0,0); }
   }
 
   //return 0;
@@ -1102,7 +1076,7 @@ extern int togeod(double a, double finv, double X, double Y, double Z,
 
     // Not Converged--Warn user
     if (i == maxit) {
-        printf("Problem in TOGEOD, did not converge in %2d iterations\n", i);
+        evlog(EV_TOGEODIT,i,0,0,0);
     }
   } // for i = 1:maxit
 
@@ -1112,7 +1086,7 @@ extern int togeod(double a, double finv, double X, double Y, double Z,
   return 0;
 
 errorDetected:
-    printf("togeod--- errorDetected\n");
+    evlog(EV_TOGEOD,0,0,0,0);
     return -1;
 
 } // end function
@@ -1152,7 +1126,7 @@ double h;
 
 ret = togeod(6378137, 298.257223563, X[0], X[1], X[2], &phi, &lambda, &h);
 if (ret!=0) {
- printf("togeod function: error\n");
+ evlog(EV_TOGEOD,0,0,0,0);
 }
 
 double cl  = cos(lambda * D2R);
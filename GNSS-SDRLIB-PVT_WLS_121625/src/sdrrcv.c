@@ -493,6 +493,49 @@ extern int rcvgrabdata(sdrini_t *ini)
         return 0;
 }
 
+/* publish front end data ------------------------------------------------------
+* advance the buffer count after a front end block has been copied to the
+* memory buffer and wake up the threads waiting for data. the publishing
+* thread is placed in the ingest role on its first block
+* args   : none
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void rcvpublish(void)
+{
+        uint64_t t0=probens();
+
+        schedrole(ROLE_INGEST);
+        probethread("sdr-ingest");
+
+        mlock(hreadmtx);
+        sdrstat.buffcnt++;
+        setevents(hbuffevt);
+        unmlock(hreadmtx);
+        traceend(TRACE_PUBLISH,-1,t0);
+}
+
+/* wait front end data ---------------------------------------------------------
+* block until the buffer count reaches cnt (data published by the front end)
+* args   : uint64_t cnt     I   buffer count to wait for
+*          int    waitms    I   max wait time (ms)
+* return : uint64_t             current buffer count
+* note : returns early at timeout or stop (check the returned count)
+*-----------------------------------------------------------------------------*/
+extern uint64_t rcvwaitbuff(uint64_t cnt, int waitms)
+{
+        struct timespec timeout;
+        uint64_t buffcnt;
+
+        settimeout(&timeout,waitms);
+        mlock(hreadmtx);
+        while (sdrstat.buffcnt<cnt&&!sdrstat.stopflag) {
+                if (timedwaitevent(hbuffevt,hreadmtx,&timeout)) break;
+        }
+        buffcnt=sdrstat.buffcnt;
+        unmlock(hreadmtx);
+        return buffcnt;
+}
+
 /* grab current buffer ---------------------------------------------------------
 * get current data buffer from memory buffer
 * args   : sdrini_t *ini    I   sdr initialization struct
@@ -594,9 +637,7 @@ extern void file_pushtomembuf(void)
                 SDRPRINTF("end of file!\n");
         }
 
-        mlock(hreadmtx);
-        sdrstat.buffcnt++;
-        unmlock(hreadmtx);
+        rcvpublish();
 }
 
 /* get current data buffer from IF file ----------------------------------------
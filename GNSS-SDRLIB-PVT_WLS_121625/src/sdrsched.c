@@ -0,0 +1,212 @@
+//-----------------------------------------------------------------------------
+// sdrsched.c : SDR thread placement (cpu affinity, scheduling, NUMA node)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// memory policy (linux/mempolicy.h, no libnuma needed). the node masks hold
+// MAXNODE bits, the kernel takes the mask size as maxnode-1.
+#define MPOL_DEFAULT_  0
+#define MPOL_PREFERRED_ 1
+#define MPOL_MF_MOVE_  (1<<1)
+
+// role names (ini key prefix in lower case)
+static const char *rolename[ROLES]={"ingest","channel","sync","gui"};
+
+static cpu_set_t proccpus;        // process cpu set
+static int nproccpus=0;           // number of process cpus
+static int reported[ROLES];       // role placement reported
+static __thread int threadrole=-1; // role applied to the calling thread
+
+// parse cpu list --------------------------------------------------------------
+// parse a cpu list such as "0-3,6" (empty: no cpus)
+// args   : char   *str      I   cpu list
+//          cpu_set_t *set   O   cpu set
+// return : int                  number of cpus (-1: error)
+//-----------------------------------------------------------------------------
+extern int parsecpus(const char *str, cpu_set_t *set)
+{
+    const char *p=str;
+    char *q;
+    long a,b,i;
+
+    CPU_ZERO(set);
+    while (*p) {
+        while (*p==' '||*p==',') p++;
+        if (!*p) break;
+        a=strtol(p,&q,10);
+        if (q==p||a<0||a>=CPU_SETSIZE) return -1;
+        b=a;
+        p=q;
+        if (*p=='-') {
+            b=strtol(++p,&q,10);
+            if (q==p||b<a||b>=CPU_SETSIZE) return -1;
+            p=q;
+        }
+        while (*p==' ') p++;
+        if (*p&&*p!=',') return -1;
+        for (i=a;i<=b;i++) CPU_SET(i,set);
+    }
+    return CPU_COUNT(set);
+}
+
+// scheduling policy name ------------------------------------------------------
+static const char *policyname(int policy)
+{
+    return policy==SCHED_FIFO?"FIFO":policy==SCHED_RR?"RR":"OTHER";
+}
+
+// process cpu affinity --------------------------------------------------------
+// set the cpus of the process ([THREADS] CPUS). without a list all cpus but
+// the last four (left to the OS) are used, or all cpus on small machines.
+// threads inherit the set unless their role has its own cpu list.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void schedprocess(void)
+{
+    int i,ncpu=sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (sdrini.cpus[0]) {
+        if ((nproccpus=parsecpus(sdrini.cpus,&proccpus))<=0) {
+            SDRPRINTF("error: wrong inifile value CPUS=%s\n",sdrini.cpus);
+            nproccpus=0;
+        }
+    }
+    if (nproccpus<=0) {
+        CPU_ZERO(&proccpus);
+        for (i=0;i<(ncpu>4?ncpu-4:ncpu);i++) CPU_SET(i,&proccpus);
+        nproccpus=CPU_COUNT(&proccpus);
+    }
+    if (sched_setaffinity(getpid(),sizeof(cpu_set_t),&proccpus)==-1) {
+        perror("error: sched_setaffinity\n");
+    }
+    SDRPRINTF("process cpus: %d of %d\n",nproccpus,ncpu);
+}
+
+// number of role cpus ---------------------------------------------------------
+// cpus the threads of a role are placed on, from the configuration ([THREADS]
+// <ROLE>CPUS, or the process cpus without a list), not from the affinity of
+// the calling thread
+// args   : int    role      I   thread role (ROLE_???)
+// return : int                  number of cpus (>=1)
+//-----------------------------------------------------------------------------
+extern int rolecpus(int role)
+{
+    cpu_set_t cpus;
+    int n;
+
+    if (role>=0&&role<ROLES&&sdrini.role[role].cpus[0]&&
+        (n=parsecpus(sdrini.role[role].cpus,&cpus))>0) {
+        return n;
+    }
+    return nproccpus>0?nproccpus:1;
+}
+
+// place calling thread --------------------------------------------------------
+// apply the cpu set, scheduling policy/priority and NUMA node of a role to
+// the calling thread ([THREADS] <ROLE>CPUS/SCHED/PRIO/NODE). the first thread
+// of each role reports what was actually applied to the program status.
+// args   : int    role      I   thread role (ROLE_???)
+// return : none
+// note : real-time priorities are limited to RLIMIT_RTPRIO (unless root).
+//        a thread is placed once, repeated calls for its role return at once.
+//        everything is set explicitly since threads inherit their creator's
+//        placement.
+//-----------------------------------------------------------------------------
+extern void schedrole(int role)
+{
+    const sdrrole_t *r;
+    struct sched_param param={0};
+    struct rlimit rlim;
+    cpu_set_t cpus;
+    unsigned long mask[(MAXNODE+63)/64]={0};
+    char msg[MSG_LENGTH],note[64]="";
+    int policy,prio,err,ok=1;
+
+    if (threadrole==role||role<0||role>=ROLES) return;
+    threadrole=role;
+    r=&sdrini.role[role];
+
+    // cpu affinity (process cpus without a list)
+    if (!r->cpus[0]||parsecpus(r->cpus,&cpus)<=0) cpus=proccpus;
+    if (nproccpus>0&&(err=pthread_setaffinity_np(pthread_self(),
+                                                 sizeof(cpus),&cpus))) {
+        snprintf(note,sizeof(note)," affinity: %s",strerror(err));
+        ok=0;
+    }
+    // scheduling policy and priority (checked against RLIMIT_RTPRIO)
+    policy=r->policy;
+    prio=policy==SCHED_OTHER?0:r->prio;
+    if (policy!=SCHED_OTHER&&geteuid()!=0&&!getrlimit(RLIMIT_RTPRIO,&rlim)&&
+        rlim.rlim_cur!=RLIM_INFINITY&&(rlim_t)prio>rlim.rlim_cur) {
+        if (rlim.rlim_cur==0) {
+            policy=SCHED_OTHER; prio=0;
+            snprintf(note,sizeof(note)," RLIMIT_RTPRIO 0: %s not allowed",
+                policyname(r->policy));
+        }
+        else {
+            prio=(int)rlim.rlim_cur;
+            snprintf(note,sizeof(note)," RLIMIT_RTPRIO: prio %d->%d",
+                r->prio,prio);
+        }
+        ok=0;
+    }
+    param.sched_priority=prio;
+    if ((err=pthread_setschedparam(pthread_self(),policy,&param))) {
+        snprintf(note,sizeof(note)," %s/%d: %s",policyname(policy),prio,
+            strerror(err));
+        policy=SCHED_OTHER; prio=0;
+        ok=0;
+    }
+    // NUMA node of the memory allocated by the thread
+    if (r->node>=0) {
+        mask[r->node/64]=1UL<<(r->node%64);
+        if (syscall(SYS_set_mempolicy,MPOL_PREFERRED_,mask,MAXNODE+1)) {
+            snprintf(note,sizeof(note)," node %d: %s",r->node,strerror(errno));
+            ok=0;
+        }
+    }
+    else syscall(SYS_set_mempolicy,MPOL_DEFAULT_,NULL,0);
+
+    if (__atomic_exchange_n(&reported[role],1,__ATOMIC_RELAXED)) return;
+
+    snprintf(msg,sizeof(msg),"%.3f  sched: %s cpus %s %s/%d node %d%s",
+        sdrstat.elapsedTime,rolename[role],r->cpus[0]?r->cpus:"(process)",
+        policyname(policy),prio,r->node,ok?"":note);
+    add_message(msg);
+}
+
+// place ring buffer -----------------------------------------------------------
+// prefer the NUMA node of the ingest thread for the front end ring buffer
+// ([THREADS] INGESTNODE), pages already touched are moved
+// args   : void   *buff     I   buffer
+//          size_t size      I   buffer size (bytes)
+// return : none
+//-----------------------------------------------------------------------------
+extern void schedbuff(void *buff, size_t size)
+{
+    unsigned long mask[(MAXNODE+63)/64]={0};
+    long page=sysconf(_SC_PAGESIZE);
+    uintptr_t p0,p1;
+    int node=sdrini.role[ROLE_INGEST].node;
+
+    if (node<0||!buff||size==0||page<=0) return;
+
+    // whole pages of the buffer
+    p0=((uintptr_t)buff+page-1)/page*page;
+    p1=((uintptr_t)buff+size)/page*page;
+    if (p1<=p0) return;
+
+    mask[node/64]=1UL<<(node%64);
+    if (syscall(SYS_mbind,(void *)p0,p1-p0,MPOL_PREFERRED_,mask,MAXNODE+1,
+                MPOL_MF_MOVE_)) {
+        SDRPRINTF("error: ring buffer to node %d: %s\n",node,strerror(errno));
+        return;
+    }
+    SDRPRINTF("ring buffer: %.1f MB on node %d\n",size/1048576.0,node);
+}
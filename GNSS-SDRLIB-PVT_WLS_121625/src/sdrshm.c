@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+// sdrshm.c : shared memory status segment (writer, see sdrshm.h)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+static sdrshm_t *shm=NULL;         // mapped status segment
+
+// start status segment --------------------------------------------------------
+// create the shared memory object [OUTPUT] SHMNAME ("": none), map it and
+// write the header. the only syscalls of the segment are here and in
+// shmstop(), updates are plain stores.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void shmstart(void)
+{
+    void *p;
+    int fd;
+
+    if (!sdrini.shmname[0]) return;
+
+    if ((fd=shm_open(sdrini.shmname,O_RDWR|O_CREAT,0644))<0) {
+        SDRPRINTF("error: shm_open %s\n",sdrini.shmname);
+        return;
+    }
+    if (ftruncate(fd,sizeof(sdrshm_t))<0) {
+        SDRPRINTF("error: shm size %s\n",sdrini.shmname);
+        close(fd);
+        return;
+    }
+    p=mmap(NULL,sizeof(sdrshm_t),PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if (p==MAP_FAILED) {
+        SDRPRINTF("error: shm mmap %s\n",sdrini.shmname);
+        return;
+    }
+    shm=(sdrshm_t *)p;
+
+    // invalid header while the layout is written (old readers reject it)
+    __atomic_store_n(&shm->magic,0,__ATOMIC_RELEASE);
+    memset(shm,0,sizeof(sdrshm_t));
+    shm->version=SDRSHM_VERSION;
+    shm->size=sizeof(sdrshm_t);
+    shm->nch=sdrini.nch<SDRSHM_MAXCH?sdrini.nch:SDRSHM_MAXCH;
+    shm->running=1;
+    __atomic_store_n(&shm->magic,SDRSHM_MAGIC,__ATOMIC_RELEASE);
+
+    SDRPRINTF("status segment: /dev/shm%s\n",sdrini.shmname);
+}
+
+// publish status --------------------------------------------------------------
+// copy the solution, the observations, the channel states and the counters to
+// the segment (sync thread, each output epoch). the sync thread writes the
+// navigation results itself, the channel values are relaxed loads.
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void shmpublish(void)
+{
+    sdrshmsat_t *s;
+    sdrshmch_t *c;
+    const double *o;
+    int i;
+
+    if (!shm) return;
+
+    seqwritebegin(shm->seq);
+    shm->epoch++;
+    shm->nsat=sdrstat.nsatValid;
+    shm->shed=sdrstat.shed;
+    shm->buffcnt=__atomic_load_n(&sdrstat.buffcnt,__ATOMIC_RELAXED);
+    shm->elapsed=sdrstat.elapsedTime;
+    shm->load=sdrstat.load;
+    shm->lat=sdrstat.lat;
+    shm->lon=sdrstat.lon;
+    shm->hgt=sdrstat.hgt;
+    shm->gdop=sdrstat.gdop;
+    memcpy(shm->xyzdt,sdrstat.xyzdt,sizeof(shm->xyzdt));
+
+    // satellites (obs_v rows)
+    for (i=0;i<SDRSHM_MAXSAT&&i<MAXSAT;i++) {
+        s=&shm->sat[i];
+        o=&sdrstat.obs_v[i*11];
+        s->prn=(int32_t)o[0];
+        s->valid=(int32_t)o[1];
+        s->pos[0]=o[2]; s->pos[1]=o[3]; s->pos[2]=o[4];
+        s->pr=o[5];
+        s->tow=o[6];
+        s->week=(int32_t)o[7];
+        s->snr=o[8];
+        s->az=o[9];
+        s->el=o[10];
+        s->resid=sdrstat.vk1_v[i];
+    }
+    // channel slots
+    for (i=0;i<shm->nch;i++) {
+        c=&shm->ch[i];
+        c->prn=__atomic_load_n(&sdrch[i].prn,__ATOMIC_RELAXED);
+        c->flagacq=__atomic_load_n(&sdrch[i].flagacq,__ATOMIC_RELAXED);
+        c->flaglock=__atomic_load_n(&sdrch[i].trk.flaglock,__ATOMIC_RELAXED);
+        c->flagsync=__atomic_load_n(&sdrch[i].nav.flagsync,__ATOMIC_RELAXED);
+        c->flagsyncf=__atomic_load_n(&sdrch[i].nav.flagsyncf,__ATOMIC_RELAXED);
+        c->flagdec=__atomic_load_n(&sdrch[i].nav.flagdec,__ATOMIC_RELAXED);
+        c->catchup=__atomic_load_n(&sdrch[i].trk.flagcatchup,__ATOMIC_RELAXED);
+        __atomic_load(&sdrch[i].trk.cn0,&c->cn0,__ATOMIC_RELAXED);
+        __atomic_load(&sdrch[i].trk.pli,&c->pli,__ATOMIC_RELAXED);
+        __atomic_load(&sdrch[i].trk.D[0],&c->doppler,__ATOMIC_RELAXED);
+        __atomic_load(&sdrch[i].trk.backlog,&c->lagms,__ATOMIC_RELAXED);
+        c->overrun=__atomic_load_n(&sdrstat.chcnt[i].overrun,__ATOMIC_RELAXED);
+        c->dropsamp=__atomic_load_n(&sdrstat.chcnt[i].dropsamp,
+                                    __ATOMIC_RELAXED);
+        c->nreset=__atomic_load_n(&sdrstat.chcnt[i].nreset,__ATOMIC_RELAXED);
+        c->trksamp=__atomic_load_n(&sdrch[i].trksamp,__ATOMIC_RELAXED);
+        c->cpuus=__atomic_load_n(&sdrch[i].cpuus,__ATOMIC_RELAXED);
+    }
+    seqwriteend(shm->seq);
+}
+
+// stop status segment ---------------------------------------------------------
+// mark the receiver stopped, unmap and remove the object (mapped readers keep
+// the last status)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void shmstop(void)
+{
+    if (!shm) return;
+
+    seqwritebegin(shm->seq);
+    shm->running=0;
+    seqwriteend(shm->seq);
+    munmap(shm,sizeof(sdrshm_t));
+    shm=NULL;
+    shm_unlink(sdrini.shmname);
+}
@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// sdrshm.h : shared memory status segment (layout and reader functions)
+//
+// the receiver publishes its status at each output epoch in the POSIX shared
+// memory object [OUTPUT] SHMNAME (default /gnss-sdrlib). the layout is fixed
+// (fixed width fields, no pointers) and versioned: readers check the magic,
+// version and size. the segment is updated under a sequence lock: a reader
+// copies what it needs between sdrshmbegin() and sdrshmretry() and retries
+// while the receiver was writing. readers never block the receiver.
+//
+// this header is self-contained for external tools (no sdr.h):
+//
+//   const sdrshm_t *shm=sdrshmopen(SDRSHM_NAME);
+//   do {
+//       seq=sdrshmbegin(shm);
+//       lat=shm->lat; ...
+//   } while (sdrshmretry(shm,seq));
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#ifndef SDRSHM_H
+#define SDRSHM_H
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SDRSHM_NAME    "/gnss-sdrlib"  // default shared memory object name
+#define SDRSHM_MAGIC   0x4d485353      // segment magic ("SSHM")
+#define SDRSHM_VERSION 1               // layout version (changed on any change)
+#define SDRSHM_MAXSAT  32              // satellites (GPS PRN 1-32)
+#define SDRSHM_MAXCH   32              // channel slots
+
+// satellite observation (the obs_v row of a PRN, named fields)
+typedef struct {
+        int32_t prn;     // PRN
+        int32_t valid;   // observation used in the solution
+        double pos[3];   // satellite position (ECEF, m)
+        double pr;       // pseudorange (m)
+        double tow;      // time of week (s)
+        int32_t week;    // GPS week
+        int32_t pad;
+        double snr;      // SNR (dB-Hz)
+        double az,el;    // azimuth and elevation (deg)
+        double resid;    // estimator residual (m)
+} sdrshmsat_t;
+
+// channel slot tracking state and counters
+typedef struct {
+        int32_t prn;     // PRN (0: none)
+        int32_t flagacq; // acquired and tracking
+        int32_t flaglock; // lock detector (C/N0 and PLL lock indicator)
+        int32_t flagsync; // navigation bit synchronization
+        int32_t flagsyncf; // navigation frame synchronization
+        int32_t flagdec; // navigation data decoded
+        int32_t catchup; // catch-up mode
+        int32_t pad;
+        double cn0;      // C/N0 (dB-Hz)
+        double pli;      // PLL lock indicator
+        double doppler;  // doppler frequency (Hz)
+        double lagms;    // samples behind the front end (ms)
+        uint64_t overrun; // ring buffer overruns
+        uint64_t dropsamp; // samples overwritten before tracking
+        uint64_t nreset; // channel resets
+        uint64_t trksamp; // samples tracked
+        uint64_t cpuus;  // channel cpu time (us)
+} sdrshmch_t;
+
+// status segment
+typedef struct {
+        uint32_t magic;  // SDRSHM_MAGIC
+        uint32_t version; // SDRSHM_VERSION
+        uint32_t size;   // sizeof(sdrshm_t)
+        uint32_t seq;    // sequence lock (odd: update in progress)
+        int32_t running; // receiver running (0: stopped)
+        int32_t nch;     // channel slots
+        int32_t nsat;    // satellites in the solution
+        int32_t shed;    // load shedding level
+        uint64_t epoch;  // status updates
+        uint64_t buffcnt; // front end blocks published
+        double elapsed;  // receiver run time (s)
+        double load;     // channel thread cpu load
+        double lat,lon,hgt; // position (deg, deg, m)
+        double gdop;     // GDOP
+        double xyzdt[4]; // ECEF position (m) and clock bias
+        sdrshmsat_t sat[SDRSHM_MAXSAT]; // satellites (index: PRN-1)
+        sdrshmch_t ch[SDRSHM_MAXCH]; // channel slots
+} sdrshm_t;
+
+// begin read ------------------------------------------------------------------
+// wait for a stable sequence (no update in progress)
+static inline uint32_t sdrshmbegin(const sdrshm_t *shm)
+{
+    uint32_t v;
+    while ((v=__atomic_load_n(&shm->seq,__ATOMIC_ACQUIRE))&1) ;
+    return v;
+}
+
+// end read --------------------------------------------------------------------
+// 1: the segment was updated while reading (read again)
+static inline int sdrshmretry(const sdrshm_t *shm, uint32_t v)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&shm->seq,__ATOMIC_RELAXED)!=v;
+}
+
+// map status segment (read only) ----------------------------------------------
+// return NULL if not found or of another layout (magic, version, size)
+static inline const sdrshm_t *sdrshmopen(const char *name)
+{
+    const sdrshm_t *shm;
+    struct stat st;
+    int fd;
+
+    if ((fd=shm_open(name,O_RDONLY,0))<0) return NULL;
+    if (fstat(fd,&st)<0||st.st_size<(off_t)sizeof(sdrshm_t)) {
+        close(fd);
+        return NULL;
+    }
+    shm=(const sdrshm_t *)mmap(NULL,sizeof(sdrshm_t),PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if (shm==MAP_FAILED) return NULL;
+    if (shm->magic!=SDRSHM_MAGIC||shm->version!=SDRSHM_VERSION||
+        shm->size!=sizeof(sdrshm_t)) {
+        munmap((void *)shm,sizeof(sdrshm_t));
+        return NULL;
+    }
+    return shm;
+}
+
+// unmap status segment --------------------------------------------------------
+static inline void sdrshmclose(const sdrshm_t *shm)
+{
+    if (shm) munmap((void *)shm,sizeof(sdrshm_t));
+}
+#endif // SDRSHM_H
@@ -0,0 +1,205 @@
+//-----------------------------------------------------------------------------
+// sdrslot.c : SDR channel slots and PRN assets (dynamic PRN assignment)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+static sdrprn_t sdrprn[MAXSAT]; // PRN assets ([CHANNEL] PRN list entries)
+
+// initialize slot channel -----------------------------------------------------
+// initialize the channel struct of a slot for a PRN asset
+// args   : int    slot      I   slot index (0-nch-1)
+//          int    k         I   PRN asset index (0-nprn-1)
+// return : int                  0:okay -1:error
+//-----------------------------------------------------------------------------
+extern int slotinitch(int slot, int k)
+{
+    int f=sdrini.ftype[k]-1;
+
+    if (initsdrch(slot+1,sdrini.sys[k],sdrini.prn[k],sdrini.ctype[k],
+        sdrini.dtype[f],sdrini.ftype[k],sdrini.f_gain[f],sdrini.f_bias[f],
+        sdrini.f_clock[f],sdrini.f_cf[f],sdrini.f_sf[f],sdrini.f_if[f],
+        &sdrch[slot])<0) {
+        return -1;
+    }
+    sdrch[slot].asset=k;
+    return 0;
+}
+
+// start slots -----------------------------------------------------------------
+// reset the PRN assets and assign the first assets of the PRN list to the
+// slots (nothing is known about visibility at start)
+// args   : none
+// return : int                  0:okay -1:error
+//-----------------------------------------------------------------------------
+extern int slotstart(void)
+{
+    int i;
+
+    memset(sdrprn,0,sizeof(sdrprn));
+    for (i=0;i<sdrini.nprn;i++) sdrprn[i].slot=-1;
+
+    for (i=0;i<sdrini.nch;i++) {
+        if (slotinitch(i,i)<0) return -1;
+        sdrprn[i].slot=i;
+        sdrprn[i].ttry=time(NULL);
+    }
+    SDRPRINTF("SDR channel slots: %d slots for %d PRNs\n",sdrini.nch,
+        sdrini.nprn);
+    return 0;
+}
+
+// predict elevation -----------------------------------------------------------
+// predict the elevation of a PRN asset from its last decoded ephemeris at the
+// receiver position (last fix, or XUINITIAL)
+// args   : sdrprn_t *a      I   PRN asset
+//          double *rr       I   receiver position (ECEF, m)
+//          double tow       I   receiver time of week (s)
+// return : double               elevation (deg, NAN: unknown)
+//-----------------------------------------------------------------------------
+static double predictel(const sdrprn_t *a, double *rr, double tow)
+{
+    sdreph_t eph=a->eph;
+    double dt,sv[3],dx[3],clk,az,el,d;
+    int i;
+
+    if (!a->flageph||tow<=0.0) return NAN;
+
+    dt=tow-eph.eph.toes;
+    if (dt>302400.0) dt-=604800.0;
+    else if (dt<-302400.0) dt+=604800.0;
+    if (fabs(dt)>EPHPREDS) return NAN;
+
+    if (satPos(&eph,tow,sv,&clk)!=0) return NAN;
+    for (i=0;i<3;i++) dx[i]=sv[i]-rr[i];
+    if (topocent(rr,dx,&az,&el,&d)!=0) return NAN;
+    return el;
+}
+
+// acquisition rank ------------------------------------------------------------
+// order of free assets without a prediction by acquisition history: fewest
+// failed acquisitions in a row, then most successful acquisitions, then least
+// recently tried
+static int rankbefore(const sdrprn_t *a, const sdrprn_t *b)
+{
+    if (a->nfail!=b->nfail) return a->nfail<b->nfail;
+    if (a->nacq!=b->nacq) return a->nacq>b->nacq;
+    return a->ttry<b->ttry;
+}
+
+// select PRN asset ------------------------------------------------------------
+// select the asset for a slot (hslotmtx locked). free assets predicted
+// visible come first (highest elevation), then free assets without a
+// prediction (by acquisition history, see rankbefore()), then the own asset
+// of the slot. assets in backoff or predicted below SV_EL_RESET_MASK are
+// skipped.
+// args   : int    own       I   asset of the slot
+// return : int                  selected asset
+//-----------------------------------------------------------------------------
+static int selectasset(int own)
+{
+    sdrnavsnap_t snap;
+    double rr[3],r,tow,el,bestel=0.0;
+    time_t now=time(NULL);
+    int i,k,cls,best=own,bestcls=0;
+
+    // receiver position and time for the prediction
+    getnavsnap(&snap);
+    r=sqrt(snap.xyzdt[0]*snap.xyzdt[0]+snap.xyzdt[1]*snap.xyzdt[1]+
+           snap.xyzdt[2]*snap.xyzdt[2]);
+    for (i=0;i<3;i++) {
+        rr[i]=r>1E6?snap.xyzdt[i]:(double)sdrini.xu0_v[i];
+    }
+    tow=sdrstat.obsnext/1000.0;
+
+    for (k=0;k<sdrini.nprn;k++) {
+        if (k==own||sdrprn[k].slot>=0||sdrprn[k].tretry>now) continue;
+
+        el=predictel(&sdrprn[k],rr,tow);
+        if (!isnan(el)) {
+            if (el<SV_EL_RESET_MASK) continue;
+            cls=2;
+        }
+        else cls=1;
+
+        if (cls>bestcls||(cls==bestcls&&(cls==2?el>bestel:
+                          rankbefore(&sdrprn[k],&sdrprn[best])))) {
+            best=k; bestcls=cls; bestel=el;
+        }
+    }
+    return best;
+}
+
+// release PRN asset -----------------------------------------------------------
+// record why the PRN of a slot was lost (backoff before it is tried again,
+// ephemeris kept for the visibility prediction) and select the asset the
+// slot continues with (may be the same when nothing better is free)
+// args   : sdrch_t *sdr     I   sdr channel struct (slot)
+//          int    cause     I   release cause (SLOT_???)
+// return : int                  asset for the slot
+//-----------------------------------------------------------------------------
+extern int slotrelease(sdrch_t *sdr, int cause)
+{
+    sdrprn_t *a=&sdrprn[sdr->asset];
+    time_t now=time(NULL);
+    int k,backoff;
+
+    mlock(hslotmtx);
+    if (sdr->nav.flagdec&&sdr->nav.sdreph.eph.week!=0) {
+        a->eph=sdr->nav.sdreph;
+        a->flageph=ON;
+    }
+    switch (cause) {
+        case SLOT_ACQFAIL:
+            a->nfail++;
+            backoff=ACQRETRYS*a->nfail;
+            if (backoff>ACQRETRYMAX) backoff=ACQRETRYMAX;
+            break;
+        case SLOT_LOWEL: a->nlost++; backoff=SLOTLOWELS; break;
+        case SLOT_LOST:  a->nlost++; backoff=SLOTLOSTS;  break;
+        default:         backoff=0; break;
+    }
+    a->tretry=now+backoff;
+
+    k=selectasset(sdr->asset);
+    if (k!=sdr->asset) {
+        a->slot=-1;
+        sdrprn[k].slot=sdr->no-1;
+        sdrprn[k].ttry=now;
+    }
+    unmlock(hslotmtx);
+
+    // acquisition failures rotate the PRNs silently
+    if (cause!=SLOT_ACQFAIL) {
+        evlog(EV_SLOTREL+cause,sdr->no,sdr->prn,backoff,sdrini.prn[k]);
+    }
+    return k;
+}
+
+// acquisition success ---------------------------------------------------------
+// args   : sdrch_t *sdr     I   sdr channel struct (slot)
+// return : none
+//-----------------------------------------------------------------------------
+extern void slotacquired(sdrch_t *sdr)
+{
+    mlock(hslotmtx);
+    sdrprn[sdr->asset].nacq++;
+    sdrprn[sdr->asset].nfail=0;
+    unmlock(hslotmtx);
+}
+
+// channel of PRN --------------------------------------------------------------
+// look up the slot which currently has a PRN (replaces sdrch[prn-1])
+// args   : int    prn       I   PRN
+// return : sdrch_t*             sdr channel struct (NULL: PRN not assigned)
+//-----------------------------------------------------------------------------
+extern sdrch_t *prnch(int prn)
+{
+    int i;
+
+    for (i=0;i<sdrini.nch;i++) {
+        if (sdrch[i].prn==prn) return &sdrch[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,221 @@
+//-----------------------------------------------------------------------------
+// sdrsup.c : SDR supervisor thread (real-time load monitor, load shedding)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+
+// shed level names
+static const char *shedname[SHEDLEVELS]={
+    "none","acquisition paused","E/P/L taps only","long loop",
+    "weak channels dropped"
+};
+
+// per channel totals (for sizing the hardware)
+static double cputot[MAXSAT];   // channel thread cpu time (s)
+static double sigtot[MAXSAT];   // signal tracked (s)
+static int dropstk[MAXSAT];     // dropped channels (last dropped on top)
+static int ndrop=0;             // number of dropped channels
+
+// drop weakest channel --------------------------------------------------------
+// drop the tracking channel with the lowest elevation (lowest SNR for equal
+// elevation or channels without elevation) unless SHEDMINCH would be left
+// args   : double load      I   channel thread cpu load
+// return : int                  1:dropped 0:nothing to drop
+//-----------------------------------------------------------------------------
+static int dropchannel(double load)
+{
+    int i,j=-1,n=0,prn;
+    double el,snr,elmin=999.0,snrmin=999.0;
+    char msg[MSG_LENGTH];
+
+    for (i=0;i<sdrini.nch;i++) {
+        if (!sdrch[i].flagacq||sdrstat.shedch[i]) continue;
+        n++;
+        prn=sdrch[i].prn;
+        el=getnavobs(prn,0)!=0.0?getnavobs(prn,10):-90.0;
+        snr=getsnr(&sdrch[i]);
+
+        if (el<elmin||(el==elmin&&snr<snrmin)) {
+            elmin=el; snrmin=snr; j=i;
+        }
+    }
+    if (j<0||n<=SHEDMINCH) return 0;
+
+    sdrstat.shedch[j]=ON;
+    dropstk[ndrop++]=j;
+    sdrstat.shedcnt[SHED_DROP]++;
+
+    snprintf(msg,sizeof(msg),"%.3f  supervisor: load %.0f%%, %s dropped "
+        "(el %.1f, SNR %.1f), %d dropped",sdrstat.elapsedTime,load*100.0,
+        sdrch[j].satstr,elmin,snrmin,ndrop);
+    add_message(msg);
+    return 1;
+}
+
+// shed load -------------------------------------------------------------------
+// apply the next shedding action (escalate one level or drop a channel)
+// args   : double load      I   channel thread cpu load
+// return : none
+//-----------------------------------------------------------------------------
+static void shedmore(double load)
+{
+    char msg[MSG_LENGTH];
+
+    if (sdrstat.shed==SHED_DROP) {
+        dropchannel(load);
+        return;
+    }
+    sdrstat.shed++;
+    if (sdrstat.shed!=SHED_DROP) sdrstat.shedcnt[sdrstat.shed]++;
+
+    snprintf(msg,sizeof(msg),"%.3f  supervisor: load %.0f%%, shed level %d "
+        "(%s)",sdrstat.elapsedTime,load*100.0,sdrstat.shed,
+        shedname[sdrstat.shed]);
+    add_message(msg);
+
+    if (sdrstat.shed==SHED_DROP) dropchannel(load);
+}
+
+// restore load ----------------------------------------------------------------
+// undo the last shedding action (restore a channel or lower one level)
+// args   : double load      I   channel thread cpu load
+// return : none
+//-----------------------------------------------------------------------------
+static void shedless(double load)
+{
+    int i;
+    char msg[MSG_LENGTH];
+
+    if (ndrop>0) {
+        i=dropstk[--ndrop];
+        sdrstat.shedch[i]=OFF;
+        snprintf(msg,sizeof(msg),"%.3f  supervisor: load %.0f%%, %s "
+            "restored, %d dropped",sdrstat.elapsedTime,load*100.0,
+            sdrch[i].satstr,ndrop);
+        add_message(msg);
+        return;
+    }
+    if (sdrstat.shed==SHED_NONE) return;
+    sdrstat.shed--;
+
+    snprintf(msg,sizeof(msg),"%.3f  supervisor: load %.0f%%, shed level %d "
+        "(%s)",sdrstat.elapsedTime,load*100.0,sdrstat.shed,
+        shedname[sdrstat.shed]);
+    add_message(msg);
+}
+
+// supervisor thread -----------------------------------------------------------
+// real-time load monitor and load shedding
+// args   : void   *arg      I   not used
+// return : none
+// note : every SUPINTMS the cpu time of the channel threads is compared with
+//        the wall time (cpu load over the channel cpus) and with the signal
+//        time they tracked (per channel real-time factor). channels in
+//        catch-up with a growing backlog also count as overload. under
+//        overload the load is shed in order: pause blind acquisition, E/P/L
+//        taps only, long loop interval for strong channels, drop the lowest
+//        elevation/SNR channels. it is restored in reverse order when the
+//        headroom comes back. every action is logged and counted.
+//-----------------------------------------------------------------------------
+extern void *supthread(void *arg)
+{
+    int i,ncpu,nover=0,nhead=0,nlag,ncatch,flag;
+    uint64_t cpu,samp,cpu0[MAXSAT]={0},samp0[MAXSAT]={0},dcpu,dsamp;
+    unsigned long tick,tick0;
+    double dt,busy,load,snr;
+
+    schedrole(ROLE_GUI);
+    probethread("sdr-sup");
+
+    // usable cpus (channel cpus, not the affinity of this GUI role thread)
+    ncpu=rolecpus(ROLE_CHANNEL);
+    tick0=tickgetus();
+
+    while (!sdrstat.stopflag) {
+        sleepms(SUPINTMS);
+        lockprofreport();
+        probesample();
+
+        tick=tickgetus();
+        dt=(tick-tick0)*1E-6;
+        tick0=tick;
+        if (dt<=0.0) continue;
+
+        // channel thread cpu time and tracked signal time
+        busy=0.0; nlag=ncatch=0;
+        for (i=0;i<sdrini.nch;i++) {
+            cpu=__atomic_load_n(&sdrch[i].cpuus,__ATOMIC_RELAXED);
+            samp=__atomic_load_n(&sdrch[i].trksamp,__ATOMIC_RELAXED);
+            dcpu=cpu>=cpu0[i]?cpu-cpu0[i]:cpu;      // reset of the channel
+            dsamp=samp>=samp0[i]?samp-samp0[i]:samp;
+            cpu0[i]=cpu; samp0[i]=samp;
+
+            busy+=dcpu*1E-6;
+            cputot[i]+=dcpu*1E-6;
+            if (sdrch[i].f_sf>0.0) sigtot[i]+=dsamp/sdrch[i].f_sf;
+
+            if (sdrch[i].flagacq&&sdrch[i].trk.flagcatchup) {
+                ncatch++;
+                if (sdrch[i].trk.backlogtrend>0.0) nlag++;
+            }
+        }
+        load=busy/(dt*ncpu);
+        sdrstat.load=load;
+        if (load>sdrstat.loadmax) sdrstat.loadmax=load;
+        sdrstat.shedsec[sdrstat.shed]+=dt;
+
+        // overload/headroom check (hysteresis and hold time)
+        if (load>SHEDLOADHI||nlag>0) {
+            nhead=0;
+            if (++nover>=SHEDHOLDHI) {
+                shedmore(load);
+                nover=0;
+            }
+        }
+        else if (load<SHEDLOADLO&&ncatch==0) {
+            nover=0;
+            if (++nhead>=SHEDHOLDLO&&(sdrstat.shed>SHED_NONE||ndrop>0)) {
+                shedless(load);
+                nhead=0;
+            }
+        }
+        else {
+            nover=nhead=0;
+        }
+
+        // long loop interval for strong channels (applied at a bit boundary)
+        for (i=0;i<sdrini.nch;i++) {
+            snr=getsnr(&sdrch[i]);
+            flag=sdrstat.shed>=SHED_LOOP&&sdrch[i].nav.flagsync&&
+                 snr>=SHEDSNR;
+            if (flag!=sdrch[i].trk.flagloopshed) {
+                sdrch[i].trk.flagloopshed=flag;
+                if (flag) sdrstat.shedcnt[SHED_LOOP]++;
+            }
+        }
+    }
+    return THRETVAL;
+}
+
+// supervisor summary ----------------------------------------------------------
+// print load shedding counters and per channel cost (after the GUI is closed)
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void supsummary(void)
+{
+    int i;
+
+    SDRPRINTF("supervisor: peak load %.0f%%, %d channels dropped at exit\n",
+        sdrstat.loadmax*100.0,ndrop);
+    for (i=0;i<SHEDLEVELS;i++) {
+        SDRPRINTF("  shed level %d %-22s %8.1f s  actions %d\n",i,shedname[i],
+            sdrstat.shedsec[i],sdrstat.shedcnt[i]);
+    }
+    for (i=0;i<sdrini.nch;i++) {
+        if (sigtot[i]<=0.0) continue;
+        SDRPRINTF("  %s cpu %7.1f s  tracked %7.1f s  cpu/tracked %.3f\n",
+            sdrch[i].satstr,cputot[i],sigtot[i],cputot[i]/sigtot[i]);
+    }
+}
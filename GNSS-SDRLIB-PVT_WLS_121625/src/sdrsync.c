@@ -5,77 +5,242 @@
 //-----------------------------------------------------------------------------
 #include "sdr.h"
 
+// observation epoch passed ---------------------------------------------------
+// check epoch a is at or after epoch b (ms of week, week rollover)
+//-----------------------------------------------------------------------------
+static int epochpassed(int a, int b)
+{
+    int d=a-b;
+
+    if (d<-WEEKMS/2) d+=WEEKMS;
+    else if (d>WEEKMS/2) d-=WEEKMS;
+    return d>=0;
+}
+
+// output epoch due ------------------------------------------------------------
+static int epochdue(int epoch)
+{
+    return sdrstat.obsnext==0||epochpassed(epoch,sdrstat.obsnext);
+}
+
+// last observation epoch of a channel (written by its tracking) -------------
+static int obsepoch(const sdrch_t *sdr)
+{
+    return __atomic_load_n(&sdr->trk.obsepoch,__ATOMIC_RELAXED);
+}
+
+// active channel for observation ----------------------------------------------
+static int obsactive(const sdrch_t *sdr)
+{
+    return sdr->nav.flagdec&&sdr->nav.sdreph.eph.week!=0&&obsepoch(sdr)>0;
+}
+
+// observation epoch reached ---------------------------------------------------
+// called from tracking when trk.tow[0] is on an OUTMS boundary. wakes up the
+// sync thread when all active channels have passed the next output epoch.
+// args   : sdrch_t *sdr     I/O sdr channel struct
+//          int    epoch     I   observation epoch (ms of week)
+// return : none
+// note : hobsmtx is only taken to signal (no lost wakeup), tracking never
+//        waits for the sync thread
+//-----------------------------------------------------------------------------
+extern void syncepoch(sdrch_t *sdr, int epoch)
+{
+    int i;
+
+    __atomic_store_n(&sdr->trk.obsepoch,epoch,__ATOMIC_RELAXED);
+    if (!obsactive(sdr)||!epochdue(epoch)) return;
+
+    for (i=0;i<sdrini.nch;i++) {
+        if (obsactive(&sdrch[i])&&!epochdue(obsepoch(&sdrch[i]))) return;
+    }
+    mlock(hobsmtx);
+    setevents(hepochevt);
+    unmlock(hobsmtx);
+}
+
+// copy observation window -----------------------------------------------------
+// copy the interpolation window of a channel (from the epoch to OBSWINMS
+// before it) from its observation history under the sequence lock
+// args   : sdrch_t *sdr     I   sdr channel struct
+//          int    epoch     I   observation epoch (ms of week)
+//          sdrobswin_t *win O   observation window
+// return : int                  1:copied 0:epoch not in the history
+//-----------------------------------------------------------------------------
+static int getobswin(sdrch_t *sdr, int epoch, sdrobswin_t *win)
+{
+    sdrtrk_t *trk=&sdr->trk;
+    unsigned int seq;
+    int j,nwin;
+
+    do {
+        seq=seqreadbegin(&trk->obsseq);
+        for (j=0;j<OBSINTERPN;j++) {
+            if (fabs(trk->tow[j]-epoch/1000.0)<1E-4) break;
+        }
+        if (j==OBSINTERPN) continue;
+
+        nwin=OBSWINMS/trk->loopms+4;
+        if (nwin>OBSINTERPN-j) nwin=OBSINTERPN-j;
+
+        win->n=nwin;
+        win->tow=trk->tow[j];
+        win->S=trk->S[0];
+        memcpy(win->codei,trk->codei+j,sizeof(uint64_t)*nwin);
+        memcpy(win->cntout,trk->cntout+j,sizeof(uint64_t)*nwin);
+        memcpy(win->remcout,trk->remcout+j,sizeof(double)*nwin);
+        memcpy(win->L,trk->L+j,sizeof(double)*nwin);
+        memcpy(win->D,trk->D+j,sizeof(double)*nwin);
+    } while (seqreadretry(trk->obsseq,seq));
+
+    if (j==OBSINTERPN) {
+        SDRPRINTF("error:%s reftow=%.1f tow=%.1f\n",sdr->satstr,
+            epoch/1000.0,trk->tow[OBSINTERPN-1]);
+        return 0;
+    }
+    return 1;
+}
+
+// wait observation epoch ------------------------------------------------------
+// wait until all active channels have passed the next output epoch and copy
+// their interpolation windows (tracking is not blocked while copying)
+// args   : sdrobswin_t *win O   observation windows of the active channels
+//          int    *isat    O   channel index of the windows
+// return : int                 number of windows (0: stop)
+//-----------------------------------------------------------------------------
+static int waitepoch(sdrobswin_t *win, int *isat)
+{
+    struct timespec timeout;
+    int i,n,epoch=0;
+
+    mlock(hobsmtx);
+    while (!sdrstat.stopflag) {
+        // oldest epoch of the active channels
+        for (i=n=0;i<sdrini.nch;i++) {
+            if (!obsactive(&sdrch[i])) continue;
+            if (n++==0||!epochpassed(obsepoch(&sdrch[i]),epoch)) {
+                epoch=obsepoch(&sdrch[i]);
+            }
+        }
+        if (n>0&&epochdue(epoch)) break;
+
+        settimeout(&timeout,DATAWAITMS);
+        timedwaitevent(hepochevt,hobsmtx,&timeout);
+    }
+    unmlock(hobsmtx);
+    if (sdrstat.stopflag) return 0;
+
+    for (i=n=0;i<sdrini.nch;i++) {
+        if (!obsactive(&sdrch[i])) continue;
+        if (getobswin(&sdrch[i],epoch,&win[n])) isat[n++]=i;
+    }
+    sdrstat.obsnext=(epoch+sdrini.outms)%WEEKMS;
+    return n;
+}
+
+// publish navigation status ---------------------------------------------------
+// copy the navigation results of the sync thread to the status snapshot
+// (hobsvecmtx locked) which the GUI and the channels read lock free
+//-----------------------------------------------------------------------------
+static void publishnav(void)
+{
+    sdrnavsnap_t *snap=&sdrstat.navsnap;
+
+    seqwritebegin(snap->seq);
+    snap->nsatValid=sdrstat.nsatValid;
+    memcpy(snap->obsValidList,sdrstat.obsValidList,sizeof(snap->obsValidList));
+    snap->lat=sdrstat.lat;
+    snap->lon=sdrstat.lon;
+    snap->hgt=sdrstat.hgt;
+    snap->gdop=sdrstat.gdop;
+    memcpy(snap->xyzdt,sdrstat.xyzdt,sizeof(snap->xyzdt));
+    memcpy(snap->obs_v,sdrstat.obs_v,sizeof(snap->obs_v));
+    memcpy(snap->vk1_v,sdrstat.vk1_v,sizeof(snap->vk1_v));
+    memcpy(snap->rk1_v,sdrekf.rk1_v,sizeof(snap->rk1_v));
+    seqwriteend(snap->seq);
+}
+
+// get navigation status -------------------------------------------------------
+// copy the navigation status snapshot (lock free, retried while published)
+// args   : sdrnavsnap_t *snap O navigation status snapshot
+// return : none
+//-----------------------------------------------------------------------------
+extern void getnavsnap(sdrnavsnap_t *snap)
+{
+    unsigned int seq;
+
+    do {
+        seq=seqreadbegin(&sdrstat.navsnap.seq);
+        memcpy(snap,&sdrstat.navsnap,sizeof(sdrnavsnap_t));
+    } while (seqreadretry(sdrstat.navsnap.seq,seq));
+}
+
+// get navigation observation --------------------------------------------------
+// get one field of the obs_v row of a PRN from the snapshot (lock free)
+// args   : int    prn       I   PRN (1-MAXSAT)
+//          int    k         I   obs_v field (0-10)
+// return : double               field value (0.0: PRN out of range, no row)
+//-----------------------------------------------------------------------------
+extern double getnavobs(int prn, int k)
+{
+    unsigned int seq;
+    double val;
+
+    if (prn<1||prn>MAXSAT||k<0||k>10) return 0.0;
+
+    do {
+        seq=seqreadbegin(&sdrstat.navsnap.seq);
+        val=sdrstat.navsnap.obs_v[(prn-1)*11+k];
+    } while (seqreadretry(sdrstat.navsnap.seq,seq));
+    return val;
+}
+
 // synchronization thread ------------------------------------------------------
 // synchronization thread for pseudo range computation
 // args   : void   *arg      I   not used
 //* return : none
 // note : this thread collects all data of sdr channel thread and compute pseudo
-//        range at every output timing.
+//        range at every output timing. it sleeps until all active channels
+//        have reached the output epoch (see syncepoch()).
 //*-----------------------------------------------------------------------------
 extern void *syncthread(void * arg)
 {
-    int i,j,nsat,isat[MAXOBS],ind[MAXSAT]={0},refi;
-    uint64_t sampref,sampbase,codei[MAXSAT],diffcnt,mincodei;
-    double codeid[OBSINTERPN],remcode[MAXSAT],samprefd,reftow=0,oldreftow;
+    int i,nsat,isat[MAXSAT],refi;
+    uint64_t sampref,sampbase,codei[MAXSAT],diffcnt,mincodei,t0;
+    double codeid[OBSINTERPN],remcode[MAXSAT],samprefd,reftow;
     sdrobs_t obs[MAXSAT];
-    sdrtrk_t trk[MAXSAT]={{0}};
+    static sdrobswin_t win[MAXSAT];
     int ret=0; // used for function output
-    char bufferSync[MSG_LENGTH];
 
-    while (!sdrstat.stopflag) {
+    schedrole(ROLE_SYNC);
+    probethread("sdr-sync");
 
-        mlock(hobsmtx);
-         // copy all tracking data   
-        for (i=nsat=0;i<sdrini.nch;i++) {
-            if (sdrch[i].nav.flagdec&&sdrch[i].nav.sdreph.eph.week!=0) {
-                memcpy(&trk[nsat],&sdrch[i].trk,sizeof(sdrch[i].trk));
-                isat[nsat]=i;
-                nsat++;
-            }
-        }
-        unmlock(hobsmtx);
+    while (!sdrstat.stopflag) {
 
-         // find minimum tow channel (most distant satellite)   
-        oldreftow=reftow;
-        reftow=3600*24*7;
-        for (i=0;i<nsat;i++) {
-            if (trk[i].tow[0]<reftow)
-                reftow=trk[i].tow[0];
-        }
-         // output timing check   
-        if (nsat==0||oldreftow==reftow||((int)(reftow*1000)%sdrini.outms)!=0) {
+         // wait for the output epoch and copy the interpolation windows   
+        if ((nsat=waitepoch(win,isat))==0) {
             continue;
         }
-         // select same timing index   
-        for (i=0;i<nsat;i++) {
-            for (j=0;j<OBSINTERPN;j++) {
-                if (fabs(trk[i].tow[j]-reftow)<1E-4) {
-                    ind[i]=j;
-                    break;
-                }
-            }
-            if (j==OBSINTERPN-1&&ind[i]==0)
-                SDRPRINTF("error:%s reftow=%.1f tow=%.1f\n",
-                    sdrch[isat[i]].satstr,trk[i].tow[OBSINTERPN-1],reftow);
-        }
+        t0=probens();
+        reftow=win[0].tow;
 
          // decide reference satellite (nearest satellite)   
         mincodei=UINT64_MAX;
         refi=0;
         for (i=0;i<nsat;i++) {
-            codei[i]=trk[i].codei[ind[i]];
-            remcode[i]=trk[i].remcout[ind[i]];
-            if (trk[i].codei[ind[i]]<mincodei) {
+            codei[i]=win[i].codei[0];
+            remcode[i]=win[i].remcout[0];
+            if (win[i].codei[0]<mincodei) {
                 refi=i;
-                mincodei=trk[i].codei[ind[i]];
+                mincodei=win[i].codei[0];
             }
         }
          // reference satellite   
-        diffcnt=trk[refi].cntout[ind[refi]]-sdrch[isat[refi]].nav.firstsfcnt;
+        diffcnt=win[refi].cntout[0]-sdrch[isat[refi]].nav.firstsfcnt;
         sampref=sdrch[isat[refi]].nav.firstsf+
             (uint64_t)(sdrch[isat[refi]].nsamp*
             (-PTIMING/(1000*sdrch[isat[refi]].ctime)+diffcnt));
-        sampbase=trk[refi].codei[OBSINTERPN-1]-10*sdrch[isat[refi]].nsamp;
+        sampbase=win[refi].codei[win[refi].n-1]-10*sdrch[isat[refi]].nsamp;
         samprefd=(double)(sampref-sampbase);
 
          // computation observation data   
@@ -88,10 +253,10 @@ extern void *syncthread(void * arg)
                 ((double)(codei[i]-sampref)-remcode[i]);  // pseudo range   
 
              // uint64 to double for interp1   
-            uint64todouble(trk[i].codei,sampbase,OBSINTERPN,codeid);
-            obs[i].L=interp1(codeid,trk[i].L,OBSINTERPN,samprefd);
-            obs[i].D=interp1(codeid,trk[i].D,OBSINTERPN,samprefd);
-            obs[i].S=trk[i].S[0];
+            uint64todouble(win[i].codei,sampbase,win[i].n,codeid);
+            obs[i].L=interp1(codeid,win[i].L,win[i].n,samprefd);
+            obs[i].D=interp1(codeid,win[i].D,win[i].n,samprefd);
+            obs[i].S=win[i].S;
         }
 
         // Populate the obs_v vector with the initial obs data and nsat.
@@ -138,20 +303,30 @@ extern void *syncthread(void * arg)
         mlock(hobsvecmtx);
         nsat = sdrstat.nsatValid;
         unmlock(hobsvecmtx);
+        probeadd(STAGE_SYNC,-1,t0);
+        traceend(TRACE_SYNC,-1,t0);
 
         if (nsat >= 4) {
+            t0=probens();
             ret = pvtProcessor();
+            probeadd(STAGE_PVT,-1,t0);
+            traceend(TRACE_PVT,-1,t0);
             if (ret != 0) {
-              printf("errorDetected: exiting pvtProcessor\n");
+              evlog(EV_PVTERR,0,0,0,0);
             }
         }
         else {
-            snprintf(bufferSync, sizeof(bufferSync),
-                 "%.3f  pvtProcessor: PVT not solved for, less than four SVs",
-                 sdrstat.elapsedTime);
-            add_message(bufferSync);
+            evlog(EV_PVTFEW,0,0,0,0);
         }
 
+        // Publish the navigation status for the GUI and the channels
+        mlock(hobsvecmtx);
+        publishnav();
+        unmlock(hobsvecmtx);
+
+        // Status segment for external readers (sdrshm.h)
+        shmpublish();
+
         // Print obs and nav data to file if printflag selected
         if (sdrstat.printflag) {
           FILE *fptr;
@@ -167,7 +342,7 @@ extern void *syncthread(void * arg)
             fprintf(fptr, "%.14e\n", obs[k].P);
           }
           for (int k=0;k<nsat;k++) {
-             int ind = obs[k].prn-1;
+             int ind = isat[k];
              fprintf(fptr, "%d\n", sdrch[ind].nav.sdreph.eph.sat);
              fprintf(fptr, "%.14e\n", 0.0);
              //fprintf(fptr, "%.14e\n", sdrch[ind].nav.sdreph.eph.toc);
@@ -0,0 +1,251 @@
+//-----------------------------------------------------------------------------
+// sdrtrace.c : pipeline activity tracer (Chrome trace-event JSON)
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include "sdr.h"
+#include <sys/syscall.h>
+
+#define MAXTRACETHREAD 128             // max traced threads
+#define TRACEEVENTS   65536            // events per thread buffer (power of 2)
+#define TRACEFLUSHMS  200              // flusher interval (ms)
+
+// event names and categories
+static const char *tracename[TRACES]={
+    "publish","acquisition","correlate","navigation","sync epoch","pvt",
+    "reset"
+};
+static const char *tracecat[TRACES]={
+    "ingest","channel","channel","channel","sync","sync","slot"
+};
+
+// trace event (complete event: start and duration)
+typedef struct {
+        uint64_t ts;     // start time (ns, probens())
+        uint32_t dur;    // duration (ns)
+        short ev;        // event (TRACE_???)
+        short ch;        // channel (slot) index (-1: none)
+        int prn;         // PRN of the channel
+} traceev_t;
+
+// per thread event buffer (single producer: the thread, consumer: flusher)
+typedef struct {
+        unsigned int head __attribute__((aligned(CACHELINE))); // next write
+        unsigned int tail __attribute__((aligned(CACHELINE))); // next read
+        uint64_t drop;   // events dropped (buffer full)
+        int tid;         // thread id
+        char name[16];   // thread name
+        traceev_t ev[TRACEEVENTS]; // events
+} tracebuf_t;
+
+static tracebuf_t *tbuf[MAXTRACETHREAD]; // thread buffers
+static int ntbuf=0;                 // number of thread buffers
+static __thread tracebuf_t *mybuf=NULL; // buffer of the calling thread
+static int traceon=0;               // tracing switched on
+static int tracequit=0;             // flusher stop request
+static uint64_t tracet0;            // trace start (ns)
+static FILE *tracefp=NULL;          // trace file
+static thread_t htracethread;       // flusher thread
+static pthread_mutex_t htracemtx=PTHREAD_MUTEX_INITIALIZER; // open/close
+
+// thread buffer ---------------------------------------------------------------
+static tracebuf_t *getbuf(void)
+{
+    tracebuf_t *b;
+    int i;
+
+    if (mybuf) return mybuf;
+    if (__atomic_load_n(&ntbuf,__ATOMIC_RELAXED)>=MAXTRACETHREAD) return NULL;
+    if (posix_memalign((void **)&b,CACHELINE,sizeof(tracebuf_t))) return NULL;
+    memset(b,0,sizeof(tracebuf_t));
+    b->tid=(int)syscall(SYS_gettid);
+    if (pthread_getname_np(pthread_self(),b->name,sizeof(b->name))) {
+        snprintf(b->name,sizeof(b->name),"tid %d",b->tid);
+    }
+    if ((i=__atomic_fetch_add(&ntbuf,1,__ATOMIC_RELAXED))>=MAXTRACETHREAD) {
+        free(b);
+        return NULL;
+    }
+    __atomic_store_n(&tbuf[i],b,__ATOMIC_RELEASE);
+    return mybuf=b;
+}
+
+// record event ----------------------------------------------------------------
+// record an event of the calling thread from t0 (probens()) until now. a full
+// buffer drops the event (counted), no-op while tracing is off
+// args   : int    ev        I   event (TRACE_???)
+//          int    ch        I   channel (slot) index (-1: none)
+//          uint64_t t0      I   event start (ns)
+// return : none
+//-----------------------------------------------------------------------------
+extern void traceend(int ev, int ch, uint64_t t0)
+{
+    tracebuf_t *b;
+    traceev_t *e;
+    unsigned int h;
+    uint64_t now;
+
+    if (!__atomic_load_n(&traceon,__ATOMIC_RELAXED)||!(b=getbuf())) return;
+
+    now=probens();
+    h=b->head;
+    if (h-__atomic_load_n(&b->tail,__ATOMIC_ACQUIRE)>=TRACEEVENTS) {
+        b->drop++;
+        return;
+    }
+    e=&b->ev[h&(TRACEEVENTS-1)];
+    e->ts=t0;
+    e->dur=now-t0>UINT32_MAX?UINT32_MAX:(uint32_t)(now-t0);
+    e->ev=(short)ev;
+    e->ch=(short)ch;
+    e->prn=ch>=0&&ch<MAXSAT?sdrch[ch].prn:0;
+    __atomic_store_n(&b->head,h+1,__ATOMIC_RELEASE);
+}
+
+// write events ----------------------------------------------------------------
+// move the recorded events of all threads to the trace file
+static void drain(void)
+{
+    static int nnamed=0;
+    tracebuf_t *b;
+    traceev_t *e;
+    unsigned int h,t;
+    int i,n=__atomic_load_n(&ntbuf,__ATOMIC_RELAXED);
+
+    if (n>MAXTRACETHREAD) n=MAXTRACETHREAD;
+    for (i=0;i<n;i++) {
+        if (!(b=__atomic_load_n(&tbuf[i],__ATOMIC_ACQUIRE))) continue;
+
+        // thread name metadata (once per thread)
+        if (i>=nnamed) {
+            fprintf(tracefp,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",b->tid,b->name);
+            nnamed=i+1;
+        }
+        h=__atomic_load_n(&b->head,__ATOMIC_ACQUIRE);
+        for (t=b->tail;t!=h;t++) {
+            e=&b->ev[t&(TRACEEVENTS-1)];
+            if (e->ts<tracet0) continue;
+            fprintf(tracefp,"{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+                tracename[e->ev],tracecat[e->ev],(e->ts-tracet0)*1E-3,
+                e->dur*1E-3,b->tid);
+            if (e->ch>=0) {
+                fprintf(tracefp,",\"args\":{\"ch\":%d,\"prn\":%d}",e->ch+1,
+                    e->prn);
+            }
+            fprintf(tracefp,"},\n");
+        }
+        __atomic_store_n(&b->tail,h,__ATOMIC_RELEASE);
+    }
+    fflush(tracefp);
+}
+
+// flusher thread --------------------------------------------------------------
+static void *tracethread(void *arg)
+{
+    schedrole(ROLE_GUI);
+    probethread("sdr-trace");
+
+    while (!__atomic_load_n(&tracequit,__ATOMIC_RELAXED)) {
+        sleepms(TRACEFLUSHMS);
+        drain();
+    }
+    drain();
+    return THRETVAL;
+}
+
+// open trace file -------------------------------------------------------------
+// create the trace file ([TRACE] FILE) and start the flusher thread (htracemtx
+// locked, at the first switch on)
+static int traceopen(void)
+{
+    if (tracefp) return 0;
+
+    if (!(tracefp=fopen(sdrini.tracefile,"w"))) return -1;
+    fprintf(tracefp,"[\n");
+    tracet0=probens();
+    if (pthread_create(&htracethread,NULL,tracethread,NULL)) {
+        fclose(tracefp);
+        tracefp=NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// start tracer ----------------------------------------------------------------
+// with [TRACE] ON=1 open the trace file ([TRACE] FILE) and switch tracing on.
+// otherwise nothing is opened or started until the 't' key switches it on
+// (an earlier trace file is kept until then).
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void tracestart(void)
+{
+    if (!sdrini.tracefile[0]) return;
+
+    if (!sdrini.traceon) {
+        SDRPRINTF("trace: %s (off, 't' key)\n",sdrini.tracefile);
+        return;
+    }
+    pthread_mutex_lock(&htracemtx);
+    if (traceopen()<0) {
+        SDRPRINTF("error: trace file %s\n",sdrini.tracefile);
+    } else {
+        __atomic_store_n(&traceon,1,__ATOMIC_RELAXED);
+        SDRPRINTF("trace: %s (on)\n",sdrini.tracefile);
+    }
+    pthread_mutex_unlock(&htracemtx);
+}
+
+// switch tracer ---------------------------------------------------------------
+// switch tracing on or off at runtime ('t' key). the first switch on opens
+// the trace file and starts the flusher.
+// args   : none
+// return : int                  1:on 0:off -1:no trace file -2:open error
+//-----------------------------------------------------------------------------
+extern int tracetoggle(void)
+{
+    int ret;
+
+    if (!sdrini.tracefile[0]) return -1;
+
+    pthread_mutex_lock(&htracemtx);
+    if (__atomic_load_n(&tracequit,__ATOMIC_RELAXED)) ret=0; // stopped
+    else if (traceopen()<0) ret=-2;
+    else ret=__atomic_xor_fetch(&traceon,1,__ATOMIC_RELAXED);
+    pthread_mutex_unlock(&htracemtx);
+    return ret;
+}
+
+// stop tracer -----------------------------------------------------------------
+// stop the flusher after the last events (all other threads joined) and
+// close the trace file
+// args   : none
+// return : none
+//-----------------------------------------------------------------------------
+extern void tracestop(void)
+{
+    uint64_t drop=0;
+    int i;
+
+    pthread_mutex_lock(&htracemtx);
+    __atomic_store_n(&tracequit,1,__ATOMIC_RELAXED);
+    pthread_mutex_unlock(&htracemtx);
+    if (!tracefp) return;
+
+    __atomic_store_n(&traceon,0,__ATOMIC_RELAXED);
+    waitthread(htracethread);
+
+    // buffers are kept until exit (front end threads may still run)
+    for (i=0;i<ntbuf&&i<MAXTRACETHREAD;i++) {
+        if (tbuf[i]) drop+=tbuf[i]->drop;
+    }
+    fprintf(tracefp,"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+        "\"args\":{\"name\":\"gnss-sdrlib-pvt (%llu events dropped)\"}}\n]\n",
+        (unsigned long long)drop);
+    fclose(tracefp);
+    tracefp=NULL;
+    SDRPRINTF("trace: %s closed, %llu events dropped\n",sdrini.tracefile,
+        (unsigned long long)drop);
+}
@@ -6,62 +6,238 @@
 //-----------------------------------------------------------------------------
 #include "sdr.h"
 
-/* sdr tracking function -------------------------------------------------------
-* sdr tracking function called from sdr channel thread
+/* track one code period -------------------------------------------------------
+* correlation, navigation bit, loop filters and observation data of one code
+* period (epoch)
 * args   : sdrch_t *sdr      I/O sdr channel struct
-*          uint64_t buffloc  I   buffer location
+*          char   *data      I   sampling data of the epoch (currnsamp)
+*          uint64_t buffloc  I   buffer location of the epoch
 *          uint64_t cnt      I   counter of sdr channel thread
+*          uint64_t *loopcnt I/O loop filter counter
+* return : none
+*-----------------------------------------------------------------------------*/
+static void trackepoch(sdrch_t *sdr, const char *data, uint64_t buffloc,
+                       uint64_t cnt, uint64_t *loopcnt)
+{
+    double IEPL[3],QEPL[3],*II,*QQ;
+    uint64_t t0;
+    int *corrp,corrn,n;
+    corrfunc_t func;
+
+    memcpy(sdr->trk.oldI,sdr->trk.II,(1+2*sdr->trk.corrn)*sizeof(double));
+    memcpy(sdr->trk.oldQ,sdr->trk.QQ,(1+2*sdr->trk.corrn)*sizeof(double));
+    sdr->trk.oldremcode=sdr->trk.remcode;
+    sdr->trk.oldremcarr=sdr->trk.remcarr;
+
+    /* tap set: full set if subscribed (and not shed), otherwise E/P/L */
+    if (sdr->trk.ne==0||sdr->trk.corrn==1||(sdrstat.shed<SHED_TAPS&&
+        __atomic_load_n(&sdrstat.chcnt[sdr->no-1].tapsubs,__ATOMIC_RELAXED)+
+        __atomic_load_n(&sdrstat.tapsubs,__ATOMIC_RELAXED)>0)) {
+        corrp=sdr->trk.corrp; corrn=sdr->trk.corrn;
+        II=sdr->trk.II; QQ=sdr->trk.QQ; func=sdr->trk.corrfunc;
+    } else {
+        corrp=sdr->trk.corrp+(sdr->trk.ne-1)/2; corrn=1;
+        II=IEPL; QQ=QEPL; func=sdr->trk.corrfuncepl;
+    }
+    /* correlation */
+    t0=probens();
+    if (sdr->trk.quant) {
+        bcorrelator(data,sdr->dtype,sdr->ti,sdr->currnsamp,
+            sdr->trk.carrfreq,sdr->trk.oldremcarr,sdr->trk.codefreq,
+            sdr->trk.oldremcode,corrp,corrn,QQ,II,&sdr->trk.remcode,
+            &sdr->trk.remcarr,sdr->code,sdr->clen,sdr->trk.quant);
+    } else {
+        correlator(data,sdr->dtype,sdr->ti,sdr->currnsamp,
+            sdr->trk.carrfreq,sdr->trk.oldremcarr,sdr->trk.codefreq,
+            sdr->trk.oldremcode,corrp,corrn,QQ,II,&sdr->trk.remcode,
+            &sdr->trk.remcarr,sdr->code,sdr->clen,func);
+    }
+    probeadd(STAGE_COR,sdr->no-1,t0);
+    traceend(TRACE_COR,sdr->no-1,t0);
+    if (II==IEPL) { /* E/P/L to tap positions, other taps are zero */
+        memset(sdr->trk.II,0,(1+2*sdr->trk.corrn)*sizeof(double));
+        memset(sdr->trk.QQ,0,(1+2*sdr->trk.corrn)*sizeof(double));
+        sdr->trk.II[0]=IEPL[0]; sdr->trk.II[sdr->trk.ne]=IEPL[1];
+        sdr->trk.II[sdr->trk.nl]=IEPL[2];
+        sdr->trk.QQ[0]=QEPL[0]; sdr->trk.QQ[sdr->trk.ne]=QEPL[1];
+        sdr->trk.QQ[sdr->trk.nl]=QEPL[2];
+    }
+
+    /* navigation data */
+    t0=probens();
+    sdrnavigation(sdr,buffloc,cnt);
+    probeadd(STAGE_NAV,sdr->no-1,t0);
+    traceend(TRACE_NAV,sdr->no-1,t0);
+
+    /* correlation output accumulation */
+    cumsumcorr(&sdr->trk,sdr->nav.ocode[sdr->nav.ocodei]);
+
+    /* C/N0 and lock indicators */
+    lockdetect(sdr);
+
+    sdr->trk.flagloopfilter=0;
+    if (!sdr->nav.flagsync) {
+        pll(sdr,&sdr->trk.prm1,sdr->ctime);
+        dll(sdr,&sdr->trk.prm1,sdr->ctime);
+        sdr->trk.flagloopfilter=1;
+    }
+    else if (sdr->nav.swloop) {
+        pll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
+        dll(sdr,&sdr->trk.prm2,(double)sdr->trk.loopms/1000);
+        sdr->trk.flagloopfilter=2;
+
+        /* calculate observation data */
+        if (*loopcnt%(SNSMOOTHMS/sdr->trk.loopms)==0) {
+            setobsdata(sdr,buffloc,cnt,&sdr->trk,1);
+        } else {
+            setobsdata(sdr,buffloc,cnt,&sdr->trk,0);
+        }
+
+        (*loopcnt)++;
+    }
+    if (sdr->trk.flagloopfilter) clearcumsumcorr(&sdr->trk);
+
+    /* loop interval change (load shedding) at the end of a navigation bit */
+    if (sdr->trk.flagloopfilter==2&&(sdr->nav.cnt-1)%sdr->nav.rate==0) {
+        n=sdr->trk.flagloopshed?sdr->nav.rate:sdr->trk.loopdef;
+        if (n!=sdr->trk.loop) {
+            sdr->trk.loopms=sdr->trk.loopms/sdr->trk.loop*n;
+            sdr->trk.loop=n;
+        }
+    }
+}
+
+/* tracking backlog ------------------------------------------------------------
+* update backlog (unprocessed samples behind the front end), its trend, the
+* catch-up mode and ring buffer overrun detection (overruns and overwritten
+* samples also counted per slot for the metrics, see sdrmetrics.c). samples
+* at the buffer location are already overwritten on an overrun: the channel
+* requests reacquisition (trk.flaglost=3) instead of tracking them
+* args   : sdrch_t *sdr      I/O sdr channel struct
+*          uint64_t buffloc  I   buffer location
+*          uint64_t avail    I   samples available after buffer location
+* return : int                   1:overrun 0:okay
+*-----------------------------------------------------------------------------*/
+static int trackbacklog(sdrch_t *sdr, uint64_t buffloc, uint64_t avail)
+{
+    unsigned long tick=tickgetus();
+    double backlog=avail*sdr->ti*1000.0,dt,a;
+    uint64_t ring=(uint64_t)MEMBUFFLEN*sdrstat.fendbuffsize,end;
+    sdrchcnt_t *cnt=&sdrstat.chcnt[sdr->no-1];
+
+    /* backlog trend (ms/s) */
+    if (sdr->trk.backlogtick) {
+        dt=(tick-sdr->trk.backlogtick)*1E-6;
+        if (dt>0.0) {
+            a=dt<BACKLOGTC?dt/BACKLOGTC:1.0;
+            sdr->trk.backlogtrend+=a*((backlog-sdr->trk.backlog)/dt-
+                                      sdr->trk.backlogtrend);
+        }
+    }
+    sdr->trk.backlog=backlog;
+    sdr->trk.backlogtick=tick;
+
+    /* catch-up mode (hysteresis) */
+    if (!sdr->trk.flagcatchup&&backlog>CATCHUPMS) {
+        sdr->trk.flagcatchup=ON;
+        evlog(EV_CATCHUP,sdr->prn,backlog,sdr->trk.backlogtrend,0);
+    }
+    else if (sdr->trk.flagcatchup&&backlog<CATCHUPMS/5) {
+        sdr->trk.flagcatchup=OFF;
+        evlog(EV_CAUGHTUP,sdr->prn,backlog,0,0);
+    }
+    /* ring buffer overrun (data at buffer location already overwritten) */
+    if (avail>ring) {
+        end=buffloc+avail-ring; /* end of the overwritten samples */
+        if (sdr->trk.dropend<buffloc) sdr->trk.dropend=buffloc;
+        if (end>sdr->trk.dropend) {
+            __atomic_add_fetch(&cnt->dropsamp,end-sdr->trk.dropend,
+                               __ATOMIC_RELAXED);
+            sdr->trk.dropend=end;
+        }
+        evlog(EV_OVERRUN,sdr->prn,backlog,
+              __atomic_add_fetch(&cnt->overrun,1,__ATOMIC_RELAXED),0);
+        sdr->trk.flaglost=3;
+        return 1;
+    }
+    return 0;
+}
+
+/* sdr tracking function -------------------------------------------------------
+* sdr tracking function called from sdr channel thread. one code period is
+* processed per call before navigation bit synchronization. after it, a block
+* of up to one loop interval (trk.loop code periods) is read from the buffer at
+* once and tracked period by period (per-period prompt values for bit decisions
+* and loop filter timing are unchanged). a channel with more than CATCHUPMS of
+* backlog reads up to CATCHUPBLK code periods per call until it has caught up.
+* without new data it returns at once with flagtrk=OFF and needcnt set (the
+* caller waits for the front end, see rcvwaitbuff()).
+* args   : sdrch_t *sdr      I/O sdr channel struct
+*          uint64_t *buffloc I/O buffer location
+*          uint64_t *cnt     I/O counter of sdr channel thread
+*          uint64_t *loopcnt I/O loop filter counter
 * return : uint64_t              current buffer location
 *-----------------------------------------------------------------------------*/
-extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt)
+extern uint64_t sdrtracking(sdrch_t *sdr, uint64_t *buffloc, uint64_t *cnt,
+                            uint64_t *loopcnt)
 {
     char *data=NULL;
     uint64_t bufflocnow;
+    int i,nblk=1,nmax,nread,off=0;
 
     sdr->flagtrk=OFF;
 
-    /* memory allocation */
-    data=(char*)sdrmalloc(sizeof(char)*(sdr->nsamp+100)*sdr->dtype);
-
     /* current buffer location */
     mlock(hreadmtx);
     bufflocnow=sdrstat.fendbuffsize*sdrstat.buffcnt-sdr->nsamp;
     unmlock(hreadmtx);
 
-    if (bufflocnow>buffloc) {
-        sdr->currnsamp=(int)((sdr->clen-sdr->trk.remcode)/
-            (sdr->trk.codefreq/sdr->f_sf));
-        rcvgetbuff(&sdrini,buffloc,sdr->currnsamp,sdr->ftype,sdr->dtype,data);
-
-        /*
-        int ctr;
-        if (ctr%500000 == 0) {
-          printf("currnsamp: %d, clen: %d, remcode: %.1f, codefreq: %.1f, f_sf: %.0f\n",
-            sdr->currnsamp, sdr->clen, sdr->trk.remcode, sdr->trk.codefreq,
-            sdr->f_sf);
-        }
-        ctr = ctr + 1;
-        */
-
-        memcpy(sdr->trk.oldI,sdr->trk.II,1+2*sdr->trk.corrn*sizeof(double));
-        memcpy(sdr->trk.oldQ,sdr->trk.QQ,1+2*sdr->trk.corrn*sizeof(double));
-        sdr->trk.oldremcode=sdr->trk.remcode;
-        sdr->trk.oldremcarr=sdr->trk.remcarr;
+    /* no data (flagtrk=OFF): buffer count needed for one code period */
+    if (bufflocnow<=*buffloc) {
+        sdr->needcnt=(*buffloc+sdr->nsamp)/sdrstat.fendbuffsize+1;
+        return bufflocnow;
+    }
+    /* overrun: no tracking on overwritten samples (reacquisition) */
+    if (trackbacklog(sdr,*buffloc,bufflocnow+sdr->nsamp-*buffloc)) {
+        sdr->flagtrk=ON;
+        return bufflocnow;
+    }
 
-        /* correlation */
-        correlator(data,sdr->dtype,sdr->ti,sdr->currnsamp,sdr->trk.carrfreq,
-            sdr->trk.oldremcarr,sdr->trk.codefreq, sdr->trk.oldremcode,
-            sdr->trk.corrp,sdr->trk.corrn,sdr->trk.QQ,sdr->trk.II,
-            &sdr->trk.remcode,&sdr->trk.remcarr,sdr->code,sdr->clen);
+    /* block size (max samples per code period: doppler and code remainder) */
+    nmax=sdr->nsamp+sdr->nsampchip+2;
+    if (sdr->nav.flagsync||sdr->trk.flagcatchup) {
+        nblk=(int)((bufflocnow+sdr->nsamp-*buffloc)/nmax);
+        if (nblk>(sdr->trk.flagcatchup?CATCHUPBLK:sdr->trk.loop)) {
+            nblk=sdr->trk.flagcatchup?CATCHUPBLK:sdr->trk.loop;
+        }
+        if (nblk<1) nblk=1;
+    }
+    sdr->currnsamp=(int)((sdr->clen-sdr->trk.remcode)/
+        (sdr->trk.codefreq/sdr->f_sf));
+    nread=nblk==1?sdr->currnsamp:nblk*nmax;
+
+    /* sample block (thread scratch buffer, no allocation per call) */
+    if (!(data=(char*)sdrscratch(3,sizeof(char)*(nread+100)*sdr->dtype))) {
+        SDRPRINTF("error: sdrtracking memory allocation\n");
+        return bufflocnow;
+    }
+    rcvgetbuff(&sdrini,*buffloc,nread,sdr->ftype,sdr->dtype,data);
 
-        /* navigation data */
-        sdrnavigation(sdr,buffloc,cnt);
+    for (i=0;i<nblk;i++) {
+        if (i>0) {
+            sdr->currnsamp=(int)((sdr->clen-sdr->trk.remcode)/
+                (sdr->trk.codefreq/sdr->f_sf));
+            if (off+sdr->currnsamp>nread) break;
+        }
+        trackepoch(sdr,data+off*sdr->dtype,*buffloc,*cnt,loopcnt);
 
-        sdr->flagtrk=ON;
-    } else {
-        sleepms(1);
+        off+=sdr->currnsamp;
+        *buffloc+=sdr->currnsamp;
+        (*cnt)++;
     }
-    sdrfree(data);
+    sdr->trksamp+=off;
+    sdr->flagtrk=ON;
+
     return bufflocnow;
 }
 
@@ -99,6 +275,81 @@ extern void clearcumsumcorr(sdrtrk_t *trk)
     }
 }
 
+/* lock detectors --------------------------------------------------------------
+* C/N0 (narrow/wide band power estimator), PLL lock indicator and an
+* optimistic/pessimistic lock counter, updated incrementally from the prompt
+* correlation of each code period (polarity applied as in sumI/sumQ). a block
+* is one loop interval after bit sync (bit aligned, equal to sumI/sumQ) or
+* LOCKKPRE code periods before it.
+*   NBP=(sum I)^2+(sum Q)^2, WBP=sum(I^2+Q^2), NP=NBP/WBP
+*   C/N0=10*log10((mu-1)/(T*(K-mu))), mu: mean NP of LOCKM blocks
+*   PLI=((sum I)^2-(sum Q)^2)/NBP=cos(2*phase error), smoothed
+* lock is declared after LOCKOPTMS with both C/N0 and PLI above the
+* thresholds, and lost after LOCKPESMS with both below (trk.flaglost=1).
+* without lock LOCKWAITMS after acquisition the channel gives up
+* (trk.flaglost=2, false acquisition).
+* args   : sdrch_t *sdr     I/0 sdr channel struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void lockdetect(sdrch_t *sdr)
+{
+    sdrtrk_t *trk=&sdr->trk;
+    double I=trk->II[0],Q=trk->QQ[0],nbp,np,mu,k,dt;
+
+    trk->lockI+=I;
+    trk->lockQ+=Q;
+    trk->lockW+=I*I+Q*Q;
+    trk->lockk++;
+
+    /* end of block */
+    if (sdr->nav.flagsync?!sdr->nav.swloop:trk->lockk<LOCKKPRE) return;
+
+    nbp=trk->lockI*trk->lockI+trk->lockQ*trk->lockQ;
+    dt=trk->lockk*sdr->ctime*1000.0;
+    trk->lockms+=dt;
+
+    if (trk->lockk>=2&&trk->lockW>0.0&&nbp>0.0) {
+        np=nbp/trk->lockW;
+        trk->locknp+=np;
+        trk->lockkm+=trk->lockk;
+        trk->pli+=LOCKPLIA*((trk->lockI*trk->lockI-trk->lockQ*trk->lockQ)/nbp-
+                            trk->pli);
+
+        /* C/N0 estimate */
+        if (++trk->lockm>=LOCKM) {
+            mu=trk->locknp/trk->lockm;
+            k=trk->lockkm/trk->lockm;
+            trk->cn0=mu<=1.0?0.0:mu>=k?99.0:
+                10.0*log10((mu-1.0)/(sdr->ctime*(k-mu)));
+            trk->lockm=0;
+            trk->locknp=trk->lockkm=0.0;
+        }
+        /* optimistic/pessimistic lock counter */
+        if (trk->cn0>=LOCKCN0TH&&trk->pli>=LOCKPLITH) {
+            trk->lockgood+=dt;
+            trk->lockbad=0.0;
+        }
+        else if (trk->cn0<LOCKCN0TH&&trk->pli<LOCKPLITH) {
+            trk->lockbad+=dt;
+            trk->lockgood=0.0;
+        }
+        else trk->lockgood=trk->lockbad=0.0;
+
+        if (!trk->flaglock&&trk->lockgood>=LOCKOPTMS) {
+            trk->flaglock=ON;
+        }
+        else if (trk->flaglock&&trk->lockbad>=LOCKPESMS) {
+            trk->flaglock=OFF;
+            trk->flaglost=1;
+        }
+    }
+    if (!trk->flaglock&&!trk->flaglost&&trk->lockms>=LOCKWAITMS) {
+        trk->flaglost=2;
+    }
+    trk->lockI=trk->lockQ=trk->lockW=0.0;
+    trk->lockk=0;
+}
+
 /* phase/frequency lock loop ---------------------------------------------------
 * phase/frequency lock loop (2nd order PLL with 1st order FLL)
 * carrier frequency is computed
@@ -173,7 +424,9 @@ extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt)
 }
 
 /* set observation data --------------------------------------------------------
-* calculate doppler/carrier phase/SNR
+* calculate doppler/carrier phase/SNR. signals the sync thread at the output
+* epochs. the channel is the only writer of the observation history, which is
+* updated under trk->obsseq so that readers copy it without blocking tracking
 * args   : sdrch_t *sdr     I   sdr channel struct
 *          uint64_t buffloc I   current buffer location
 *          uint64_t cnt     I   current counter of sdr channel thread
@@ -184,6 +437,9 @@ extern void dll(sdrch_t *sdr, sdrtrkprm_t *prm, double dt)
 extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt,
                        sdrtrk_t *trk, int snrflag)
 {
+    int epoch,flagepoch;
+
+    seqwritebegin(trk->obsseq);
     shiftdata(&trk->tow[1],&trk->tow[0],sizeof(double),OBSINTERPN-1);
     shiftdata(&trk->L[1],&trk->L[0],sizeof(double),OBSINTERPN-1);
     shiftdata(&trk->D[1],&trk->D[0],sizeof(double),OBSINTERPN-1);
@@ -197,6 +453,11 @@ extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt,
     trk->cntout[0]=cnt;
     trk->remcout[0]=trk->oldremcode*sdr->f_sf/trk->codefreq;
 
+    /* observation epoch (OUTMS boundary) reached */
+    epoch=(int)floor(trk->tow[0]*1000.0+0.5);
+    flagepoch=sdrini.outms>0&&epoch>0&&epoch%sdrini.outms==0&&
+              fabs(trk->tow[0]*1000.0-epoch)<0.1;
+
     /* doppler */
     trk->D[0]=-(trk->carrfreq-sdr->f_if-sdr->foffset);
 
@@ -230,4 +491,48 @@ extern void setobsdata(sdrch_t *sdr, uint64_t buffloc, uint64_t cnt,
         trk->codeisum[0]=buffloc;
         trk->Isum=0;
     }
+    seqwriteend(trk->obsseq);
+
+    /* signal after the history is complete */
+    if (flagepoch) syncepoch(sdr,epoch);
+}
+/* get latest SNR --------------------------------------------------------------
+* read the latest SNR of a channel from the observation history (lock free)
+* args   : sdrch_t *sdr     I   sdr channel struct
+* return : double               SNR (dB-Hz)
+*-----------------------------------------------------------------------------*/
+extern double getsnr(sdrch_t *sdr)
+{
+    unsigned int seq;
+    double snr;
+
+    do {
+        seq=seqreadbegin(&sdr->trk.obsseq);
+        snr=sdr->trk.S[0];
+    } while (seqreadretry(sdr->trk.obsseq,seq));
+    return snr;
+}
+/* subscribe full correlator tap set -------------------------------------------
+* request all correlation points (CORRN) for a channel. without subscribers
+* only prompt and the early/late pair used by DLL/PLL (CORRP) are computed.
+* takes effect from the next code period without resetting the channel. the
+* subscription belongs to the channel slot and is kept over channel resets.
+* args   : sdrch_t *sdr      I/O sdr channel struct (NULL: all channels)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void subscribetaps(sdrch_t *sdr)
+{
+    if (sdr) __atomic_add_fetch(&sdrstat.chcnt[sdr->no-1].tapsubs,1,
+                                __ATOMIC_RELAXED);
+    else     __atomic_add_fetch(&sdrstat.tapsubs,1,__ATOMIC_RELAXED);
+}
+/* unsubscribe full correlator tap set -----------------------------------------
+* args   : sdrch_t *sdr      I/O sdr channel struct (NULL: all channels)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void unsubscribetaps(sdrch_t *sdr)
+{
+    if (sdr) __atomic_sub_fetch(&sdrstat.chcnt[sdr->no-1].tapsubs,1,
+                                __ATOMIC_RELAXED);
+    else     __atomic_sub_fetch(&sdrstat.tapsubs,1,__ATOMIC_RELAXED);
 }
@@ -0,0 +1,84 @@
+//-----------------------------------------------------------------------------
+// sdrshmdump.c : print the receiver status segment (example reader)
+//
+// usage: sdrshmdump [-n name] [-i interval_ms] [-c count]
+//
+// Edits from Don Kelly, don.kelly@mac.com, 2025
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdrshm.h"
+
+// print one status copy -------------------------------------------------------
+static void dump(const sdrshm_t *s)
+{
+    const sdrshmsat_t *a;
+    const sdrshmch_t *c;
+    int i;
+
+    printf("epoch %llu  t %.3f s  %s  blocks %llu  load %.0f%%  shed %d\n",
+        (unsigned long long)s->epoch,s->elapsed,s->running?"running":"stopped",
+        (unsigned long long)s->buffcnt,s->load*100.0,s->shed);
+    printf("pos %.7f %.7f %.2f  gdop %.2f  sats %d\n",s->lat,s->lon,s->hgt,
+        s->gdop,s->nsat);
+
+    printf("%3s %4s %13s %14s %6s %6s %6s %8s\n","prn","used","pr (m)",
+        "tow (s)","snr","az","el","resid");
+    for (i=0;i<SDRSHM_MAXSAT;i++) {
+        a=&s->sat[i];
+        if (a->pr==0.0) continue;
+        printf("%3d %4d %13.2f %14.6f %6.1f %6.1f %6.1f %8.2f\n",a->prn,
+            a->valid,a->pr,a->tow,a->snr,a->az,a->el,a->resid);
+    }
+    printf("%3s %4s %4s %4s %6s %5s %9s %8s %8s %10s %6s\n","ch","prn","acq",
+        "lock","cn0","pli","doppler","lag ms","overrun","dropped","resets");
+    for (i=0;i<s->nch&&i<SDRSHM_MAXCH;i++) {
+        c=&s->ch[i];
+        printf("%3d %4d %4d %4d %6.1f %5.2f %9.1f %8.1f %8llu %10llu %6llu\n",
+            i+1,c->prn,c->flagacq,c->flaglock,c->cn0,c->pli,c->doppler,
+            c->lagms,(unsigned long long)c->overrun,
+            (unsigned long long)c->dropsamp,(unsigned long long)c->nreset);
+    }
+    printf("\n");
+}
+
+// main ------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    const sdrshm_t *shm;
+    sdrshm_t copy;
+    const char *name=SDRSHM_NAME;
+    uint32_t seq;
+    int i,ms=1000,count=1;
+
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-n")&&i+1<argc) name=argv[++i];
+        else if (!strcmp(argv[i],"-i")&&i+1<argc) ms=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-c")&&i+1<argc) count=atoi(argv[++i]);
+        else {
+            fprintf(stderr,"usage: %s [-n name] [-i interval_ms] [-c count "
+                "(0: forever)]\n",argv[0]);
+            return 2;
+        }
+    }
+    if (!(shm=sdrshmopen(name))) {
+        fprintf(stderr,"no status segment %s (version %d)\n",name,
+            SDRSHM_VERSION);
+        return 1;
+    }
+    for (i=0;count<=0||i<count;i++) {
+        if (i>0) usleep(ms*1000);
+
+        // consistent copy (the receiver is never blocked by the reader)
+        do {
+            seq=sdrshmbegin(shm);
+            memcpy(&copy,shm,sizeof(copy));
+        } while (sdrshmretry(shm,seq));
+
+        dump(&copy);
+        if (!copy.running) break;
+    }
+    sdrshmclose(shm);
+    return 0;
+}